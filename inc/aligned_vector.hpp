@@ -3,6 +3,8 @@
 #include "aligned_allocator.hpp"
 #include "config.hpp"
 
+#include <vector>
+
 namespace Archa {
 
 template <typename T, std::size_t ALIGNMENT_IN_BYTES = 64>
@@ -2,23 +2,110 @@
 
 #include "config.hpp"
 
+#include <optional>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "bin.hpp"
+#include "bounding_box.hpp"
 #include "render_triangle.hpp"
 
 namespace Archa {
 
+// GRID keeps every cell as a bin, for workers to take in turn; ADAPTIVE
+// gives each worker one bin of whole cells, repartitioned from measured
+// costs, which suits views that change little from frame to frame
+enum class BinLayout : uint8 { GRID, ADAPTIVE };
+
+const char *to_string(BinLayout layout);
+std::optional<BinLayout> parse_bin_layout(std::string_view name);
+
 class Binner {
+  // the screen is divided into cell_size squares, row by row, and every bin
+  // is a rectangle of whole cells
+  glm::ivec2 size{};
+  int cell_size{};
+  glm::ivec2 grid_size{};
+
+  BinLayout layout{};
+
+  // worker count the adaptive layout was partitioned for, 0 while the grid
+  // layout is in place
+  uint partition_count{};
+
   std::vector<Bin> bins{};
-  RenderTriangleGroups render_triangle_bin_groups{};
+
+  // the bin holding each cell, and how long the cell took to render in
+  // microseconds, smoothed over frames, row by row
+  std::vector<uint> cell_bins{};
+  std::vector<float> cell_times{};
+
+  // how long each bin took to render last frame, and the bins from the most
+  // to the least expensive
+  std::vector<float> bin_costs{};
+  std::vector<uint> bin_order{};
+
+  // one set of bin groups per geometry worker, so workers never share a list
+  std::vector<RenderTriangleGroups> render_triangle_queues{};
+
+  // every queue's triangles of each bin, nearest first once sorted
+  std::vector<std::vector<const RenderTriangle *>> sorted_bin_groups{};
+
+  // min and max corners of a rectangle of cells, max exclusive
+  using CellRect = std::pair<glm::ivec2, glm::ivec2>;
+
+  void set_bins(const std::vector<CellRect> &rects);
+  void set_grid_bins();
+
+  CellRect get_bin_rect(uint bin_index) const;
+
+  float get_cell_cost(const glm::ivec2 &cell) const;
+  float get_rect_cost(const CellRect &rect) const;
+
+  // k-d splits rect into count bins of even cost, cutting across its longer
+  // side each time
+  void partition(const CellRect &rect, uint count,
+                 std::vector<CellRect> &rects) const;
 
 public:
-  void split_bins(const glm::ivec2 &size, int count);
+  // starts in the grid layout, with every cell a bin
+  void split_bins(const glm::ivec2 &size, int cell_size);
+  void set_layout(BinLayout layout);
+
+  // called before binning each frame; the adaptive layout gives each of
+  // worker_count workers a bin, and is only repartitioned once its bins
+  // drift well out of balance
+  void update_layout(uint worker_count);
+
+  void resize_queues(uint count);
 
   const std::vector<Bin> &get_bins() const;
 
-  std::vector<RenderTriangle>& get_render_bin_group(uint index);
+  // the bins box overlaps, with box clipped to each; thread safe, and valid
+  // until the thread's next call
+  const std::vector<std::pair<uint, BoundingBox>> &
+  find_bins(const BoundingBox &box) const;
+
+  // records how long the cell holding pos took to render, smoothing it with
+  // earlier frames; cells may be recorded in parallel
+  void record_cell_time(const glm::ivec2 &pos, float time);
+
+  void set_bin_cost(uint bin_index, float cost);
+
+  // orders bins by the costs set since, most expensive first
+  void order_bins_by_cost();
+  const std::vector<uint> &get_bin_order() const;
+
+  std::vector<RenderTriangle> &get_render_bin_group(uint queue_index,
+                                                    uint bin_index);
+
+  // orders a bin's triangles front to back by min_z, the depth their tests
+  // use, so early depth tests reject as much as possible; safe to run per
+  // bin in parallel
+  void sort_bin(uint bin_index);
+  const std::vector<const RenderTriangle *> &
+  get_sorted_bin_group(uint bin_index) const;
 };
 
 } // namespace Archa
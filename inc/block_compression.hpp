@@ -0,0 +1,49 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+
+#include "image.hpp"
+#include "texture_format.hpp"
+#include "types.hpp"
+
+namespace Archa {
+
+constexpr uint BLOCK_TEXEL_COUNT{
+    MipLevel::TILE_SIZE * MipLevel::TILE_SIZE};
+
+using BlockTexels = std::array<uint32, BLOCK_TEXEL_COUNT>;
+
+// encodes a tile of packed RGBA texels, in row order, into get_block_size
+// bytes; endpoints come from the tile's bounding box in colour space
+void compress_block(TextureFormat format, const BlockTexels &texels,
+                    uint8 *block);
+
+void decode_block(TextureFormat format, const uint8 *block, uint32 *texels);
+
+using BlockIndices = std::array<int, BLOCK_TEXEL_COUNT>;
+
+// texels[i] = palette[indices[i]] for a whole block, with palettes of up to
+// eight entries; defined in block_compression_sse2.cpp and
+// block_compression_avx2.cpp
+#ifdef USING_SIMD_SSE2
+SSE2_TARGET void look_up_palette_sse2(const uint32 *palette,
+                                      uint palette_size,
+                                      const BlockIndices &indices,
+                                      uint32 *texels);
+#endif
+
+#ifdef USING_SIMD_AVX2
+AVX2_TARGET void look_up_palette_avx2(const uint32 *palette,
+                                      uint palette_size,
+                                      const BlockIndices &indices,
+                                      uint32 *texels);
+#endif
+
+// decoded texels of one of a compressed level's tiles, from a small per
+// thread cache so that neighbouring samples decode each tile only once; the
+// pointer is valid until the thread's next call
+const uint32 *get_decoded_tile(const MipLevel &level, uint tile);
+
+} // namespace Archa
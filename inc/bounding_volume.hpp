@@ -0,0 +1,24 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "frustum.hpp"
+#include "vertex.hpp"
+
+namespace Archa {
+
+struct BoundingVolume {
+  glm::vec3 min{}, max{};
+
+  glm::vec3 centre{};
+  float radius{};
+
+  static BoundingVolume from_points(const std::vector<Vertex> &vertices);
+
+  bool is_outside(const Frustum &frustum) const;
+};
+
+} // namespace Archa
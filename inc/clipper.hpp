@@ -0,0 +1,48 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+
+namespace Archa {
+
+enum ClipPlane : uint8 {
+  CLIP_NEAR = 1 << 0,
+  CLIP_LEFT = 1 << 1,
+  CLIP_RIGHT = 1 << 2,
+  CLIP_BOTTOM = 1 << 3,
+  CLIP_TOP = 1 << 4,
+  CLIP_FAR = 1 << 5,
+};
+
+struct ClipVertex {
+  glm::vec4 clip{};
+  glm::vec4 colour{};
+  glm::vec2 uv{};
+  glm::vec3 normal{};
+};
+
+struct ClipPolygon {
+  // a triangle gains at most one vertex per clip plane
+  static constexpr uint MAX_VERTICES{9};
+
+  std::array<ClipVertex, MAX_VERTICES> vertices{};
+  uint count{};
+};
+
+class Clipper {
+  // x/y extent of the guard band in clip space, relative to w
+  glm::vec2 guard_band{1.0f};
+
+public:
+  void set_guard_band(const glm::vec2 &guard_band);
+
+  uint8 compute_outcode(const glm::vec4 &clip) const;
+
+  void clip(ClipPolygon &polygon, uint8 planes) const;
+};
+
+} // namespace Archa
@@ -1,6 +1,8 @@
 #pragma once
 
-#define GLM_FORCE_AVX
+// glm uses its SSE2 code, which the x86-64 baseline every file is compiled for
+// always has
+#define GLM_FORCE_SSE2
 
 #ifndef FORCE_INLINE
 
@@ -12,6 +14,11 @@
 
 #endif
 
+// fractional bits of screen space vertex positions
+#ifndef SUBPIXEL_BITS
+#define SUBPIXEL_BITS 8
+#endif
+
 // #define NO_SIMD
 // #define NO_SIMD_AVX2
 
@@ -20,8 +27,11 @@
 #define NO_SIMD_AVX2
 #endif
 
+// the SSE2 and AVX2 kernels are built into every x86-64 binary, each in its
+// own *_sse2.cpp or *_avx2.cpp file, and picked at runtime; these stay the
+// same in every file so that classes agree on their layout
 #ifndef NO_SIMD_SSE2
-#ifdef __SSE2__
+#if defined(__x86_64__) || defined(_M_X64)
 #define USING_SIMD_SSE2
 #else
 #define NO_SIMD_SSE2
@@ -31,11 +41,46 @@
 #endif
 
 #if !defined(NO_SIMD_SSE2) && !defined(NO_SIMD_AVX2)
-#ifdef __AVX2__
 #define USING_SIMD_AVX2
-#else
-#define NO_SIMD_AVX2
 #endif
+
+// every file is compiled for the x86-64 baseline, so inline functions are the
+// same wherever they are compiled; only the kernels and the intrinsics
+// wrappers are compiled for their instruction set, through the attribute on
+// their declarations and the push and pop around their definitions; the SSE2
+// kernels also lean on a few SSE4.1 instructions
+#ifndef SSE2_TARGET
+
+#define PRAGMA(text) _Pragma(#text)
+
+#ifdef USING_SIMD_SSE2
+#define SSE2_TARGET __attribute__((target("sse4.1")))
+#define BEGIN_SSE2_TARGET                                                      \
+  PRAGMA(clang attribute push(__attribute__((target("sse4.1"))),              \
+                              apply_to = function))
+#define END_SSE2_TARGET PRAGMA(clang attribute pop)
+#endif
+
+#ifdef USING_SIMD_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define BEGIN_AVX2_TARGET                                                      \
+  PRAGMA(clang attribute push(__attribute__((target("avx2"))),                \
+                              apply_to = function))
+#define END_AVX2_TARGET PRAGMA(clang attribute pop)
+#endif
+
+#endif
+
+// the *_sse2.cpp and *_avx2.cpp files are built with SSE2_KERNELS or
+// AVX2_KERNELS defined, which compiles the headers' lane kernel templates
+// between BEGIN_KERNELS and END_KERNELS for their instruction set; other
+// files leave them out, so never instantiate them for the baseline
+#if defined(SSE2_KERNELS) && defined(USING_SIMD_SSE2)
+#define BEGIN_KERNELS BEGIN_SSE2_TARGET
+#define END_KERNELS END_SSE2_TARGET
+#elif defined(AVX2_KERNELS) && defined(USING_SIMD_AVX2)
+#define BEGIN_KERNELS BEGIN_AVX2_TARGET
+#define END_KERNELS END_AVX2_TARGET
 #endif
 
 #define ALIGN_SSE2_WIDTH 16
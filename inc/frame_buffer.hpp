@@ -18,17 +18,53 @@ class FrameBuffer {
   glm::ivec2 size{};
   AlignedVector<uint8, SIMD_ALIGN_WIDTH> pixels{};
 
+  // whole lanes of a fill or resolve row from x up to max_x, returning the x
+  // they stopped at; defined in frame_buffer_sse2.cpp and frame_buffer_avx2.cpp
+#ifdef USING_SIMD_SSE2
+  SSE2_TARGET int fill_lanes_sse2(const glm::ivec2 &pos, int max_x,
+                                  const Colour &colour);
+  SSE2_TARGET static int stream_lanes_sse2(const int *src, int *dest, int x,
+                                           int max_x);
+#endif
+
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET int fill_lanes_avx2(const glm::ivec2 &pos, int max_x,
+                                  const Colour &colour);
+  AVX2_TARGET static int stream_lanes_avx2(const int *src, int *dest, int x,
+                                           int max_x);
+#endif
+
 public:
   void create(const glm::ivec2 &size);
 
   void set_pixel(const glm::ivec2 &pos, const Colour &colour);
 
+  // rows of [min, max) are written a lane at a time from min.x, which should
+  // be lane aligned
+  void fill(const glm::ivec2 &min, const glm::ivec2 &max, const Colour &colour);
+
+  // copies the top left size pixels of tile to pos with streaming stores,
+  // which skip the cache as nothing reads the pixels back this frame
+  void resolve(const FrameBuffer &tile, const glm::ivec2 &pos,
+               const glm::ivec2 &size);
+
 #ifdef USING_SIMD_SSE2
-  void set_pixels(const glm::ivec2 &pos, const SSE2::Array<Colour> &colours);
+  SSE2_TARGET void set_pixels(const glm::ivec2 &pos,
+                              const SSE2::Array<Colour> &colours);
+
+  // writes the packed RGBA lanes of colours_vec whose mask is set
+  SSE2_TARGET void set_pixels_masked(const glm::ivec2 &pos,
+                                     const __m128i &colours_vec,
+                                     const __m128i &mask_vec);
 #endif
 
 #ifdef USING_SIMD_AVX2
-  void set_pixels(const glm::ivec2 &pos, const AVX2::Array<Colour> &colours);
+  AVX2_TARGET void set_pixels(const glm::ivec2 &pos,
+                              const AVX2::Array<Colour> &colours);
+
+  AVX2_TARGET void set_pixels_masked(const glm::ivec2 &pos,
+                                     const __m256i &colours_vec,
+                                     const __m256i &mask_vec);
 #endif
 
   const uint8 *get_pixels() const;
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace Archa {
+
+struct Frustum {
+  // left, right, bottom, top, near, far; inside where dot(plane, p) >= 0
+  std::array<glm::vec4, 6> planes{};
+
+  // planes are in whatever space the matrix transforms from
+  static Frustum from_matrix(const glm::mat4 &matrix);
+};
+
+} // namespace Archa
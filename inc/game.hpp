@@ -42,6 +42,8 @@ public:
             float resolution_scale = 1.0f);
 
   void run(uint max_frame_rate = 0);
+
+  Viewport &get_viewport();
 };
 
 } // namespace Archa
@@ -4,26 +4,64 @@
 
 #include <SFML/Graphics/Image.hpp>
 #include <glm/common.hpp>
+#include <vector>
 
+#include "aligned_vector.hpp"
 #include "colour.hpp"
 #include "resource.hpp"
+#include "texture_format.hpp"
 #include "types.hpp"
 
 namespace Archa {
 
+// one level of a mip chain, each texel a packed RGBA Colour; texels are
+// stored in 4x4 tiles of one cache line each, so a filter footprint touches
+// the same few lines whichever way the texture is oriented on screen
+struct MipLevel {
+  static constexpr int TILE_SHIFT{2};
+  static constexpr int TILE_SIZE{1 << TILE_SHIFT};
+
+  glm::ivec2 size{};
+  int tile_columns{};
+  AlignedVector<uint32> texels{};
+
+  // compressed levels keep one block per tile instead of texels, and an id
+  // that tags their tiles in the decoded tile cache
+  TextureFormat format{TextureFormat::RGBA8};
+  AlignedVector<uint8> blocks{};
+  uint32 id{};
+
+  // pads the storage out to whole tiles
+  void resize(const glm::ivec2 &size);
+
+  // replaces the texels with blocks of the given format
+  void compress(TextureFormat format);
+
+  uint get_index(int x, int y) const;
+  uint32 get_texel(int x, int y) const;
+};
+
 class Image : public Resource {
   glm::ivec2 size{};
   const uint8 *pixels{nullptr};
 
+  // level 0 holds the full image and each further level halves it, down to
+  // a single texel; once built, the chain is the only copy of the pixels
+  std::vector<MipLevel> mip_levels{};
+
+  void build_mip_chain();
+
 public:
   sf::Image image{};
 
   void load(const std::filesystem::path &file_path) override;
 
   const glm::ivec2 &get_size() const;
-  const uint8 *get_pixels() const;
 
-  const Colour &get_pixel(const glm::ivec2 &pos) const;
+  Colour get_pixel(const glm::ivec2 &pos) const;
+
+  uint get_level_count() const;
+  const MipLevel &get_level(uint level) const;
 };
 
 } // namespace Archa
@@ -2,20 +2,25 @@
 
 #include "config.hpp"
 
+// declares every instruction set's intrinsics whatever the file is compiled
+// for; the wrappers below are compiled for their instruction set, so are only
+// called once get_simd_level allows it, and AVX2's only from AVX2 kernels, as
+// the baseline passes 256 bit vectors differently
 #ifdef USING_SIMD_SSE2
-#include <emmintrin.h>
-#endif
-
-#ifdef USING_SIMD_AVX2
 #include <immintrin.h>
 #endif
 
 #include <array>
 
 #include "constants.hpp"
+#include "types.hpp"
 
 namespace Archa {
 
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+#endif
+
 class SSE2 {
 #ifdef USING_SIMD_SSE2
 public:
@@ -33,7 +38,12 @@ public:
   static __m128i minus_one_ints;
 
   static __m128i load_ints(const int *src);
+  static __m128i load_ints_unaligned(const int *src);
   static __m128 load_floats(const float *src);
+  static __m128 load_floats_unaligned(const float *src);
+
+  // four unsigned 16 bit values, widened to ints
+  static __m128i load_uint16s(const uint16 *src);
 
   static __m128i set_zero_int();
   static __m128 set_zero_float();
@@ -44,7 +54,12 @@ public:
   static __m128i set_ints(int a, int b, int c, int d);
   static __m128 set_floats(float a, float b, float c, float d);
 
+  static __m128i or_ints(const __m128i &a, const __m128i &b);
   static __m128i or_ints(const std::array<__m128i, 3> &vecs);
+  static __m128i and_ints(const __m128i &a, const __m128i &b);
+  static __m128i shift_left_ints(const __m128i &vec, int count);
+  static __m128i shift_right_ints(const __m128i &vec, int count);
+  static __m128 and_floats(const __m128 &a, const __m128 &b);
 
   static __m128 divide_floats(const __m128 &a, const __m128 &b);
 
@@ -58,6 +73,13 @@ public:
   static __m128i subtract_ints(const __m128i &a, const __m128i &b);
   static __m128 subtract_floats(const __m128 &a, const __m128 &b);
 
+  static __m128i min_ints(const __m128i &a, const __m128i &b);
+  static __m128i max_ints(const __m128i &a, const __m128i &b);
+  static __m128 min_floats(const __m128 &a, const __m128 &b);
+  static __m128 max_floats(const __m128 &a, const __m128 &b);
+
+  static __m128 floor_floats(const __m128 &vec);
+
   static __m128i horizontal_add_ints(const __m128i &vec);
   static __m128 horizontal_add_floats(const __m128 &vec);
 
@@ -67,15 +89,45 @@ public:
   static __m128 convert_to_floats(const __m128i &vec);
 
   static __m128i compare_ints_gt(const __m128i &a, const __m128i &b);
+  static __m128 compare_floats_lt(const __m128 &a, const __m128 &b);
+  static __m128 compare_floats_eq(const __m128 &a, const __m128 &b);
+
+  static __m128i cast_to_ints(const __m128 &vec);
+  static __m128 cast_to_floats(const __m128i &vec);
+
+  // picks b where mask is set, a elsewhere
+  static __m128i blend_ints(const __m128i &a, const __m128i &b,
+                            const __m128i &mask);
+  static __m128 blend_floats(const __m128 &a, const __m128 &b,
+                             const __m128 &mask);
 
   static int pack_as_int(__m128i vec);
   static int move_mask_int8(const __m128i &vec);
+  static int move_mask_float(const __m128 &vec);
 
   static void store_ints(int *dest, const __m128i &src);
+  static void store_ints_unaligned(int *dest, const __m128i &src);
   static void store_floats(float *dest, const __m128 &src);
+  static void store_floats_unaligned(float *dest, const __m128 &src);
+
+  // the low 16 bits of each int, saturated to [0, 65535]
+  static void store_uint16s(uint16 *dest, const __m128i &src);
+
+  // non-temporal store to an aligned dest, bypassing the cache; stores are
+  // only ordered with other threads' reads after a fence
+  static void stream_ints(int *dest, const __m128i &src);
+  static void fence_stores();
 #endif
 };
 
+#ifdef USING_SIMD_SSE2
+END_SSE2_TARGET
+#endif
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+#endif
+
 class AVX2 {
 #ifdef USING_SIMD_AVX2
 public:
@@ -101,7 +153,16 @@ public:
   }
 
   static __m256i load_ints(const int *src);
+  static __m256i load_ints_unaligned(const int *src);
+
+  // loads base[indices[i]] where mask is set, zero elsewhere
+  static __m256i mask_gather_ints(const int *base, const __m256i &indices,
+                                  const __m256i &mask);
   static __m256 load_floats(const float *src);
+  static __m256 load_floats_unaligned(const float *src);
+
+  // eight unsigned 16 bit values, widened to ints
+  static __m256i load_uint16s(const uint16 *src);
 
   static __m256i set_zero_int();
   static __m256 set_zero_float();
@@ -115,7 +176,15 @@ public:
   static __m256 set_floats(float a, float b, float c, float d, float e, float f,
                            float g, float h);
 
+  static __m256i or_ints(const __m256i &a, const __m256i &b);
   static __m256i or_ints(const std::array<__m256i, 3> &vecs);
+  static __m256i and_ints(const __m256i &a, const __m256i &b);
+  static __m256i shift_left_ints(const __m256i &vec, int count);
+  static __m256i shift_right_ints(const __m256i &vec, int count);
+
+  // lane i of the result is lane indices[i] of vec
+  static __m256i permute_ints(const __m256i &vec, const __m256i &indices);
+  static __m256 and_floats(const __m256 &a, const __m256 &b);
 
   static __m256 divide_floats(const __m256 &a, const __m256 &b);
 
@@ -128,6 +197,13 @@ public:
   static __m256i subtract_ints(const __m256i &a, const __m256i &b);
   static __m256 subtract_floats(const __m256 &a, const __m256 &b);
 
+  static __m256i min_ints(const __m256i &a, const __m256i &b);
+  static __m256i max_ints(const __m256i &a, const __m256i &b);
+  static __m256 min_floats(const __m256 &a, const __m256 &b);
+  static __m256 max_floats(const __m256 &a, const __m256 &b);
+
+  static __m256 floor_floats(const __m256 &vec);
+
   static __m256i horizontal_add_ints(const __m256i &vec);
   static __m256 horizontal_add_floats(const __m256 &vec);
 
@@ -135,14 +211,41 @@ public:
   static __m256 convert_to_floats(const __m256i &vec);
 
   static __m256i compare_ints_gt(const __m256i &a, const __m256i &b);
+  static __m256 compare_floats_lt(const __m256 &a, const __m256 &b);
+  static __m256 compare_floats_eq(const __m256 &a, const __m256 &b);
+
+  static __m256i cast_to_ints(const __m256 &vec);
+  static __m256 cast_to_floats(const __m256i &vec);
+
+  // picks b where mask is set, a elsewhere
+  static __m256 blend_floats(const __m256 &a, const __m256 &b,
+                             const __m256 &mask);
 
   static int move_mask_int8(const __m256i &vec);
+  static int move_mask_float(const __m256 &vec);
 
   static void store_ints(int *dest, const __m256i &src);
+  static void store_ints_unaligned(int *dest, const __m256i &src);
   static void store_floats(float *dest, const __m256 &src);
+  static void store_floats_unaligned(float *dest, const __m256 &src);
+
+  // the low 16 bits of each int, saturated to [0, 65535]
+  static void store_uint16s(uint16 *dest, const __m256i &src);
+
+  static void stream_ints(int *dest, const __m256i &src);
+
+  // writes only the lanes whose mask sign bit is set
+  static void mask_store_ints(int *dest, const __m256i &mask,
+                              const __m256i &src);
+  static void mask_store_floats(float *dest, const __m256i &mask,
+                                const __m256 &src);
 
   static __m256 add_floats(const std::array<__m256, 3> &vecs);
 #endif
 };
 
+#ifdef USING_SIMD_AVX2
+END_AVX2_TARGET
+#endif
+
 } // namespace Archa
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "bounding_volume.hpp"
+#include "frustum.hpp"
+#include "triangle.hpp"
+#include "types.hpp"
+#include "vertex.hpp"
+
+namespace Archa {
+
+struct Meshlet {
+  static constexpr uint MAX_TRIANGLES{64};
+
+  uint first_triangle{};
+  uint triangle_count{};
+
+  // range of vertex indices referenced by the meshlet's triangles
+  uint first_vertex{};
+  uint last_vertex{};
+
+  BoundingVolume bounds{};
+
+  // every face normal lies within the cone around the axis; a cutoff of 1 or
+  // more means the cone is too wide to ever be entirely back-facing
+  glm::vec3 cone_axis{};
+  float cone_cutoff{1.0f};
+
+  static std::vector<Meshlet> build(const std::vector<Vertex> &vertices,
+                                    const std::vector<Triangle> &triangles);
+
+  // frustum planes and camera position are in object space; a mirroring
+  // transform flips which winding faces the camera
+  bool is_culled(const Frustum &frustum, const glm::vec3 &camera_position,
+                 bool is_mirrored) const;
+};
+
+} // namespace Archa
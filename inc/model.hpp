@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 
+#include "bounding_volume.hpp"
+#include "meshlet.hpp"
 #include "resource.hpp"
 #include "triangle.hpp"
 #include "vertex.hpp"
@@ -18,7 +20,14 @@ struct Model : public Resource {
   std::vector<Vertex> vertices{};
   std::vector<Triangle> triangles{};
 
+  BoundingVolume bounds{};
+  std::vector<Meshlet> meshlets{};
+
   void load(const std::filesystem::path &file_path) override;
+
+  // bounds of the whole model and of each meshlet; must be called again
+  // whenever vertices or triangles change
+  void compute_bounds();
 };
 
 } // namespace Archa
@@ -3,320 +3,556 @@
 #include "config.hpp"
 
 #include <array>
+#include <bit>
 
-#include "barycentric_coords.hpp"
 #include "colour.hpp"
 #include "intrinsics.hpp"
+#include "render_pass.hpp"
 #include "render_target.hpp"
 #include "render_triangle.hpp"
+#include "sampler.hpp"
+#include "shading.hpp"
+#include "simd_level.hpp"
 
 namespace Archa {
 
 class PixelProcessor {
   RenderTarget &render_target;
+  const TileTriangle &tile;
   const RenderTriangle &rt;
+  RenderPass pass{};
+
+  // kernels to run, fixed for the triangle's lifetime
+  SimdLevel simd_level{};
 
   bool is_texured{};
-  glm::ivec2 texture_size{};
+
+  // whether pixels passing the depth test are shaded
+  bool is_shading{};
 
   int x{};
+  int max_x{};
+  bool is_covered{};
 
-#ifdef NO_SIMD
+  // edge functions at the row's first pixel, for the scalar path
   std::array<int, 3> w_row{};
 
-  std::array<glm::vec2, 3> abc_t{};
-#endif
-
 #ifdef USING_SIMD_SSE2
   bool was_inside{};
   bool is_outside_right{};
 
-  __m128 area_seq_vec{};
-  __m128i bias_seq_vec{};
   __m128i w_row_seq_vec{};
   __m128i w_seq_vec{};
-  __m128 clip_z_seq_vec{};
-  __m128 clip_w_seq_vec{};
   __m128i delta_w_x_seq_vec{};
   __m128i delta_w_y_seq_vec{};
 
-  __m128 abc_t_x_seq_vec{};
-  __m128 abc_t_y_seq_vec{};
-
-  std::array<__m128, 3> colours_seq_vecs{};
-
-  __m128 area_vec{};
-  __m128 texture_size_x_vec{};
-  __m128 texture_size_y_vec{};
-
-  std::array<std::array<__m128, 3>, 4> colours_vecs{};
-  std::array<__m128i, 3> bias_vecs{};
-  std::array<__m128, 3> clip_z_vec{};
-  std::array<__m128, 3> clip_w_vec{};
   std::array<__m128i, 3> delta_w_x_init_vecs{};
   std::array<__m128i, 3> delta_w_x_step_vecs{};
 
-  std::array<__m128, 3> abc_t_x_vecs{};
-  std::array<__m128, 3> abc_t_y_vecs{};
+  __m128i quad_x_vec{};
+  std::array<__m128i, 3> delta_w_quad_init_vecs{};
+  std::array<__m128i, 3> delta_w_quad_step_vecs{};
 #endif
 
 #ifdef USING_SIMD_AVX2
-  __m256 clip_w_seq_vec256{};
-  __m256 abc_t_seq_vec256{};
-
-  __m256 area_vec256{};
-  __m256 texture_size_x_vec256{};
-  __m256 texture_size_y_vec256{};
-
-  std::array<std::array<__m256, 3>, 4> colours_vec256s{};
-  std::array<__m256i, 3> bias_vec256s{};
-  std::array<__m256, 3> clip_z_vec256s{};
-  std::array<__m256, 3> clip_w_vec256s{};
   std::array<__m256i, 3> delta_w_x_init_vec256s{};
   std::array<__m256i, 3> delta_w_x_step_vec256s{};
 
-  std::array<__m256, 3> abc_t_x_vec256s{};
-  std::array<__m256, 3> abc_t_y_vec256s{};
+  __m256i quad_x_vec256{};
+  std::array<__m256i, 3> delta_w_quad_init_vec256s{};
+  std::array<__m256i, 3> delta_w_quad_step_vec256s{};
 #endif
 
-  Colour interpolate_colour(const BarycentricCoords &bc);
-  Colour interpolate_texture(const BarycentricCoords &bc);
+  void process_pixel(const glm::ivec2 &pos);
 
-  void process_pixel(const glm::ivec2 &pos, const BarycentricCoords &bc,
-                     float z);
-
-#ifdef NO_SIMD
   void iterate_pixels(int y);
-#endif
 
+  // the templates below are defined after the class for
+  // pixel_processor_sse2.cpp and pixel_processor_avx2.cpp alone, which
+  // compile them for their instruction set
 #ifdef USING_SIMD_SSE2
   bool pixel_is_inside_mask(uint i, int mask);
 
-  template <typename T>
-  typename T::template Array<float>
-  interpolate_z(const std::array<typename T::FloatVec, 3> &bc_vecs,
-                     const std::array<typename T::FloatVec, 3> &clip_z_vecs) {
+  // the triangle's attribute planes at each lane's pixel; only those the
+  // pass reads are set up and stepped
+  template <typename T> struct AttributeVecs {
+    typename T::FloatVec z{};
+    typename T::FloatVec inv_w{};
+    std::array<typename T::FloatVec, 2> uv_over_w{};
+    std::array<typename T::FloatVec, RGBA_CHANNEL_COUNT> colours{};
+  };
+
+  // evaluates the planes at the lanes starting at (x, y), and the adds that
+  // move them a whole lane along the row
+  template <typename T, bool IS_QUAD>
+  void init_attribute_vecs(int y, AttributeVecs<T> &vecs,
+                           AttributeVecs<T> &step_vecs) const;
 
-    std::array<typename T::FloatVec, 3> z_result_vec{};
-    alignas(SIMD_ALIGN_WIDTH) typename T::template Array<float> z_values{};
+  template <typename T>
+  void step_attribute_vecs(AttributeVecs<T> &vecs,
+                           const AttributeVecs<T> &step_vecs) const;
 
-    for (uint i{0}; i < bc_vecs.size(); i++)
-      z_result_vec[i] = T::multiply_floats(bc_vecs[i], clip_z_vecs[i]);
+  // whole-lane depth buffer access for a row of pixels starting at pos
+  template <typename T>
+  typename T::FloatVec
+  quantise_z_lane(const typename T::FloatVec &z_vec) const;
 
-    T::store_floats(z_values.data(), T::add_floats(z_result_vec));
+  template <typename T>
+  typename T::FloatVec get_z_lane(const glm::ivec2 &pos) const;
 
-    return z_values;
-  }
+  template <typename T>
+  void set_z_lane(const glm::ivec2 &pos, const typename T::FloatVec &z_vec,
+                  const typename T::FloatVec &mask_vec);
 
   template <typename T>
-  std::array<typename T::template Array<int>, 4> interpolate_colour(
-      const std::array<typename T::FloatVec, 3> &bc_vecs,
-      const std::array<std::array<typename T::FloatVec, 3>, 4> &colours_vecs) {
+  typename T::FloatVec
+  compare_depths(const typename T::FloatVec &z_vec,
+                 const typename T::FloatVec &stored_z_vec) const;
 
-    std::array<std::array<typename T::FloatVec, 3>, 4> colours_result_vecs{};
+  // packed RGBA, one pixel per lane
+  template <typename T>
+  typename T::IntVec interpolate_colour(const AttributeVecs<T> &vecs) const;
 
-    alignas(SIMD_ALIGN_WIDTH) std::array<typename T::template Array<int>, 4>
-        colours{};
+  // normalised texture coordinates, wrapped by the sampler
+  template <typename T>
+  std::pair<typename T::FloatVec, typename T::FloatVec>
+  interpolate_texture(const AttributeVecs<T> &vecs) const;
 
-    for (uint c{0}; c < colours_result_vecs.size(); c++) {
-      for (uint i{0}; i < colours_result_vecs[c].size(); i++)
-        colours_result_vecs[c][i] =
-            T::multiply_floats(colours_vecs[c][i], bc_vecs[i]);
+  // quads hold two rows of LANE_WIDTH / 2 pixels, lane i at
+  // (i % quad width, i / quad width)
+  template <typename T> static constexpr int QUAD_WIDTH{T::LANE_WIDTH / 2};
 
-      const auto channel_vec{
-          T::convert_to_ints(T::add_floats(colours_result_vecs[c]))};
+  // depth tests a lane, then interpolates attributes only if any pixel
+  // survives; rows write whole lanes with masked stores, while quads, whose
+  // lanes span two rows and may run past max_x, write pixel by pixel
+  template <typename T, bool IS_QUAD = false>
+  void process_pixels(int y, const typename T::IntVec &is_inside_vec,
+                      int is_inside_mask, const AttributeVecs<T> &vecs);
 
-      T::store_ints(colours[c].data(), channel_vec);
-    }
+  // depth-only kernel, testing and writing a whole lane at once
+  template <typename T>
+  void process_depth(int y, const typename T::IntVec &is_inside_vec,
+                     int is_inside_mask, const AttributeVecs<T> &vecs);
 
-    return colours;
-  }
+  template <typename T>
+  void iterate_pixels(
+      int y, const std::array<typename T::IntVec, 3> &delta_w_x_init_vecs,
+      const std::array<typename T::IntVec, 3> &delta_w_x_step_vecs);
 
+  // covers rows y and y + 1 a quad at a time, masking off lanes past max_x
   template <typename T>
-  std::pair<typename T::template Array<int>, typename T::template Array<int>>
-  interpolate_texture(
-      const typename T::FloatVec &texture_size_x_vec,
-      const typename T::FloatVec &texture_size_y_vec,
-      const std::array<typename T::FloatVec, 3> &bc_vecs,
-      const std::array<typename T::FloatVec, 3> &clip_w_vecs,
-      const std::array<typename T::FloatVec, 3> &abc_t_x_vecs,
-      const std::array<typename T::FloatVec, 3> &abc_t_y_vecs) {
-
-    std::array<typename T::FloatVec, 3> w_abc_vecs{};
-    std::array<typename T::FloatVec, 3> uv_x_abc_vecs{};
-    std::array<typename T::FloatVec, 3> uv_y_abc_vecs{};
-
-    for (uint i{0}; i < 3; i++) {
-      w_abc_vecs[i] = T::divide_floats(bc_vecs[i], clip_w_vecs[i]);
-
-      uv_x_abc_vecs[i] = T::multiply_floats(bc_vecs[i], abc_t_x_vecs[i]);
-      uv_y_abc_vecs[i] = T::multiply_floats(bc_vecs[i], abc_t_y_vecs[i]);
-    }
+  void iterate_quads(
+      int y, const typename T::IntVec &quad_x_vec,
+      const std::array<typename T::IntVec, 3> &delta_w_quad_init_vecs,
+      const std::array<typename T::IntVec, 3> &delta_w_quad_step_vecs);
+
+  // sets up the lane vectors once, and the row's edge functions at min_x
+  SSE2_TARGET void init_sse2();
+  SSE2_TARGET void start_row_sse2(int min_x);
+
+  SSE2_TARGET void iterate_pixels_sse2(int y);
+  SSE2_TARGET void iterate_pixels_sequentially_sse2(int y);
+  SSE2_TARGET void iterate_quads_sse2(int y);
+#endif
 
-    const auto w_t_vec{T::add_floats(w_abc_vecs)};
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET void init_avx2();
+  AVX2_TARGET void iterate_pixels_avx2(int y);
+  AVX2_TARGET void iterate_quads_avx2(int y);
+#endif
 
-    auto uv_x_vec{T::add_floats(uv_x_abc_vecs)};
-    auto uv_y_vec{T::add_floats(uv_y_abc_vecs)};
+public:
+  PixelProcessor(RenderTarget &render_target, const TileTriangle &tile,
+                 RenderPass pass);
+
+  // covers [min_x, max_x) of row y, which must lie within the triangle's box;
+  // is_covered skips coverage tests where the triangle is known to cover it
+  void iterate_x(int y, int min_x, int max_x, bool is_covered);
+
+  // covers [min_x, max_x) of rows y and y + 1 in 2D quads, which keeps more
+  // lanes busy on small and sliver triangles; y + 1 must lie within the box
+  void iterate_quad_x(int y, int min_x, int max_x, bool is_covered);
+  void step_y();
+};
 
-    uv_x_vec = T::divide_floats(uv_x_vec, w_t_vec);
-    uv_y_vec = T::divide_floats(uv_y_vec, w_t_vec);
+#ifdef BEGIN_KERNELS
+BEGIN_KERNELS
 
-    uv_x_vec =
-        T::convert_to_ints(T::multiply_floats(uv_x_vec, texture_size_x_vec));
+template <typename T, bool IS_QUAD>
+void PixelProcessor::init_attribute_vecs(int y, AttributeVecs<T> &vecs,
+                                         AttributeVecs<T> &step_vecs) const {
 
-    uv_y_vec =
-        T::convert_to_ints(T::multiply_floats(uv_y_vec, texture_size_y_vec));
+  alignas(SIMD_ALIGN_WIDTH) typename T::template Array<float> offsets_x{};
+  alignas(SIMD_ALIGN_WIDTH) typename T::template Array<float> offsets_y{};
 
-    alignas(SIMD_ALIGN_WIDTH) typename T::template Array<int> uv_x{};
-    alignas(SIMD_ALIGN_WIDTH) typename T::template Array<int> uv_y{};
+  for (int i{0}; i < T::LANE_WIDTH; i++) {
+    const auto lane{IS_QUAD ? glm::ivec2{i % QUAD_WIDTH<T>, i / QUAD_WIDTH<T>}
+                            : glm::ivec2{i, 0}};
 
-    T::store_ints(uv_x.data(), uv_x_vec);
-    T::store_ints(uv_y.data(), uv_y_vec);
+    const auto offset{glm::ivec2{x, y} + lane - tile.origin};
 
-    return {uv_x, uv_y};
+    offsets_x[static_cast<uint>(i)] = static_cast<float>(offset.x);
+    offsets_y[static_cast<uint>(i)] = static_cast<float>(offset.y);
   }
 
-  template <typename T>
-  void process_pixels(int y, int is_inside_mask,
-                           const std::array<typename T::FloatVec, 3> &bc_vecs) {
+  const auto offset_x_vec{T::load_floats(offsets_x.data())};
+  const auto offset_y_vec{T::load_floats(offsets_y.data())};
 
-    typename T::template Array<float> z_values{};
+  const auto step{static_cast<float>(IS_QUAD ? QUAD_WIDTH<T> : T::LANE_WIDTH)};
 
-    std::array<typename T::template Array<int>, 4> colours{};
+  const auto init{[&](const AttributePlane &plane, typename T::FloatVec &vec,
+                      typename T::FloatVec &step_vec) {
+    const auto x_vec{T::multiply_floats(T::set_float(plane.a), offset_x_vec)};
+    const auto y_vec{T::multiply_floats(T::set_float(plane.b), offset_y_vec)};
 
-    typename T::template Array<int> uv_x{};
-    typename T::template Array<int> uv_y{};
+    vec = T::add_floats(T::add_floats(x_vec, y_vec), T::set_float(plane.c));
 
-    if constexpr (std::is_same<T, AVX2>::value) {
-      z_values = interpolate_z_avx2(bc_vecs);
+    step_vec = T::set_float(plane.a * step);
+  }};
 
-      if (is_texured)
-        std::tie(uv_x, uv_y) = interpolate_texture_avx2(bc_vecs);
-      else
-        colours = interpolate_colour_avx2(bc_vecs);
-    }
+  init(rt.z_plane, vecs.z, step_vecs.z);
 
-    else {
-      z_values = interpolate_z_sse2(bc_vecs);
+  if (!is_shading)
+    return;
 
-      if (is_texured)
-        std::tie(uv_x, uv_y) = interpolate_texture_sse2(bc_vecs);
-      else
-        colours = interpolate_colour_sse2(bc_vecs);
-    }
+  if (is_texured) {
+    init(rt.inv_w_plane, vecs.inv_w, step_vecs.inv_w);
 
-    for (uint i{0}; i < T::LANE_WIDTH; i++) {
-      if (pixel_is_inside_mask(i, is_inside_mask)) {
-        was_inside = true;
+    for (uint i{0}; i < vecs.uv_over_w.size(); i++)
+      init(rt.uv_over_w_planes[i], vecs.uv_over_w[i], step_vecs.uv_over_w[i]);
+  } else {
+    for (uint c{0}; c < vecs.colours.size(); c++)
+      init(rt.colour_planes[c], vecs.colours[c], step_vecs.colours[c]);
+  }
+}
 
-        const glm::ivec2 pos{x + static_cast<int>(i), y};
+template <typename T>
+void PixelProcessor::step_attribute_vecs(
+    AttributeVecs<T> &vecs, const AttributeVecs<T> &step_vecs) const {
+  vecs.z = T::add_floats(vecs.z, step_vecs.z);
 
-        if (z_values[i] >= render_target.z_buffer.get(pos))
-          continue;
+  if (!is_shading)
+    return;
 
-        render_target.z_buffer.set(pos, z_values[i]);
+  if (is_texured) {
+    vecs.inv_w = T::add_floats(vecs.inv_w, step_vecs.inv_w);
 
-        Colour colour{};
+    for (uint i{0}; i < vecs.uv_over_w.size(); i++)
+      vecs.uv_over_w[i] =
+          T::add_floats(vecs.uv_over_w[i], step_vecs.uv_over_w[i]);
+  } else {
+    for (uint c{0}; c < vecs.colours.size(); c++)
+      vecs.colours[c] = T::add_floats(vecs.colours[c], step_vecs.colours[c]);
+  }
+}
 
-        if (is_texured)
-          colour = rt.triangle.diffuse_texture->get_pixel({uv_x[i], uv_y[i]});
+template <typename T>
+typename T::FloatVec
+PixelProcessor::quantise_z_lane(const typename T::FloatVec &z_vec) const {
+#ifdef USING_SIMD_AVX2
+  if constexpr (std::is_same<T, AVX2>::value)
+    return render_target.z_buffer.quantise_lane_avx2(z_vec);
+  else
+#endif
+    return render_target.z_buffer.quantise_lane_sse2(z_vec);
+}
 
-        else
-          colour = {static_cast<uint8>(colours[0][i]),
-                    static_cast<uint8>(colours[1][i]),
-                    static_cast<uint8>(colours[2][i]),
-                    static_cast<uint8>(colours[3][i])};
+template <typename T>
+typename T::FloatVec PixelProcessor::get_z_lane(const glm::ivec2 &pos) const {
+#ifdef USING_SIMD_AVX2
+  if constexpr (std::is_same<T, AVX2>::value)
+    return render_target.z_buffer.get_lane_avx2(pos);
+  else
+#endif
+    return render_target.z_buffer.get_lane_sse2(pos);
+}
 
-        render_target.frame_buffer.set_pixel(pos, colour);
-      }
+template <typename T>
+void PixelProcessor::set_z_lane(const glm::ivec2 &pos,
+                                const typename T::FloatVec &z_vec,
+                                const typename T::FloatVec &mask_vec) {
+#ifdef USING_SIMD_AVX2
+  if constexpr (std::is_same<T, AVX2>::value)
+    render_target.z_buffer.set_lane_avx2(pos, z_vec, mask_vec);
+  else
+#endif
+    render_target.z_buffer.set_lane_sse2(pos, z_vec, mask_vec);
+}
+
+template <typename T>
+typename T::FloatVec
+PixelProcessor::compare_depths(const typename T::FloatVec &z_vec,
+                               const typename T::FloatVec &stored_z_vec) const {
+  if (pass == PASS_COLOUR_EQUAL)
+    return T::compare_floats_eq(z_vec, stored_z_vec);
+
+  return T::compare_floats_lt(z_vec, stored_z_vec);
+}
+
+template <typename T>
+typename T::IntVec
+PixelProcessor::interpolate_colour(const AttributeVecs<T> &vecs) const {
+  const auto max_channel_vec{T::set_int(255)};
+
+  auto colour_vec{T::set_zero_int()};
+
+  for (uint c{0}; c < vecs.colours.size(); c++) {
+    const auto channel_vec{
+        T::min_ints(T::max_ints(T::convert_to_ints(vecs.colours[c]),
+                                T::set_zero_int()),
+                    max_channel_vec)};
+
+    colour_vec = T::or_ints(
+        colour_vec, T::shift_left_ints(channel_vec, static_cast<int>(c * 8)));
+  }
+
+  return colour_vec;
+}
+
+template <typename T>
+std::pair<typename T::FloatVec, typename T::FloatVec>
+PixelProcessor::interpolate_texture(const AttributeVecs<T> &vecs) const {
+  const auto w_vec{T::divide_floats(T::set_float(1.0f), vecs.inv_w)};
+
+  return {T::multiply_floats(vecs.uv_over_w[0], w_vec),
+          T::multiply_floats(vecs.uv_over_w[1], w_vec)};
+}
+
+template <typename T, bool IS_QUAD>
+void PixelProcessor::process_pixels(int y,
+                                    const typename T::IntVec &is_inside_vec,
+                                    int is_inside_mask,
+                                    const AttributeVecs<T> &vecs) {
+
+  // taken before the early-out below moves x to the end of the row
+  const glm::ivec2 lane_pos{x, y};
 
-      else if (was_inside) {
-        is_outside_right = true;
+  const auto get_pos{[lane_pos](uint i) {
+    return IS_QUAD ? lane_pos + glm::ivec2{static_cast<int>(i) % QUAD_WIDTH<T>,
+                                           static_cast<int>(i) / QUAD_WIDTH<T>}
+                   : lane_pos + glm::ivec2{static_cast<int>(i), 0};
+  }};
 
-        x = rt.box.max.x;
-      }
+  if constexpr (!IS_QUAD) {
+    // coverage is convex, so a row is done once it has been left
+    if (was_inside &&
+        !pixel_is_inside_mask(T::LANE_WIDTH - 1, is_inside_mask)) {
+      is_outside_right = true;
+
+      x = max_x;
     }
+
+    if (is_inside_mask)
+      was_inside = true;
   }
 
-  template <typename T>
-  void iterate_pixels(
-      int y, typename T::FloatVec &area_vec,
-      const std::array<typename T::IntVec, 3> &bias_vecs,
-      const std::array<typename T::IntVec, 3> &delta_w_x_init_vecs,
-      const std::array<typename T::IntVec, 3> &delta_w_x_step_vecs) {
+  const auto z_vec{quantise_z_lane<T>(vecs.z)};
 
-    std::array<typename T::IntVec, 3> w_vecs{
-        T::set_int(SSE2::extract_int<0>(w_seq_vec)),
-        T::set_int(SSE2::extract_int<1>(w_seq_vec)),
-        T::set_int(SSE2::extract_int<2>(w_seq_vec))};
+  typename T::FloatVec stored_z_vec{};
 
-    for (uint i{0}; i < w_vecs.size(); i++)
-      w_vecs[i] = T::add_ints(w_vecs[i], delta_w_x_init_vecs[i]);
+  if constexpr (IS_QUAD) {
+    alignas(SIMD_ALIGN_WIDTH) typename T::template Array<float> stored_z{};
 
-    for (; x < rt.box.max.x - (T::LANE_WIDTH - 1); x += T::LANE_WIDTH) {
-      std::array<typename T::IntVec, 3> w_with_bias_vecs{};
+    for (uint i{0}; i < T::LANE_WIDTH; i++)
+      if (pixel_is_inside_mask(i, is_inside_mask))
+        stored_z[i] = render_target.z_buffer.get(get_pos(i));
 
-      for (uint i{0}; i < w_vecs.size(); i++)
-        w_with_bias_vecs[i] = T::add_ints(w_vecs[i], bias_vecs[i]);
+    stored_z_vec = T::load_floats(stored_z.data());
+  } else {
+    stored_z_vec = get_z_lane<T>(lane_pos);
+  }
 
-      const auto is_inside_vec{
-          T::compare_ints_gt(T::or_ints(w_with_bias_vecs), T::minus_one_ints)};
+  const auto write_vec{T::and_floats(compare_depths<T>(z_vec, stored_z_vec),
+                                     T::cast_to_floats(is_inside_vec))};
 
-      const auto is_inside_mask{T::move_mask_int8(is_inside_vec)};
+  const auto write_mask{T::move_mask_float(write_vec)};
 
-      std::array<typename T::FloatVec, 3> bc_vecs{};
+  if (!write_mask)
+    return;
 
-      for (uint i{0}; i < bc_vecs.size(); i++)
-        bc_vecs[i] =
-            T::divide_floats(T::convert_to_floats(w_vecs[i]), area_vec);
+  const auto is_writing_lane{
+      [&](uint i) { return static_cast<bool>((write_mask >> i) & 1); }};
 
-      process_pixels<T>(y, is_inside_mask, bc_vecs);
+  if (pass != PASS_COLOUR_EQUAL) {
+    if constexpr (IS_QUAD) {
+      alignas(SIMD_ALIGN_WIDTH) typename T::template Array<float> z_values{};
+      T::store_floats(z_values.data(), z_vec);
 
-      for (uint i{0}; !is_outside_right & (i < w_vecs.size()); i++)
-        w_vecs[i] = T::add_ints(w_vecs[i], delta_w_x_step_vecs[i]);
+      for (uint i{0}; i < T::LANE_WIDTH; i++)
+        if (is_writing_lane(i))
+          render_target.z_buffer.set(get_pos(i), z_values[i]);
+    } else {
+      set_z_lane<T>(lane_pos, z_vec, write_vec);
     }
+  }
+
+  if (pass == PASS_VISIBILITY)
+    for (uint i{0}; i < T::LANE_WIDTH; i++)
+      if (is_writing_lane(i))
+        render_target.visibility_buffer.set(get_pos(i), rt.id);
+
+  if (!is_shading)
+    return;
+
+  typename T::IntVec colour_vec{};
+
+  if (is_texured) {
+    const auto [u_vec, v_vec]{interpolate_texture<T>(vecs)};
 
-    w_seq_vec = SSE2::set_ints(0, T::template extract_int<0>(w_vecs[2]),
-                               T::template extract_int<0>(w_vecs[1]),
-                               T::template extract_int<0>(w_vecs[0]));
+    // a whole lane group samples one mip level, chosen at its first
+    // written pixel
+    const auto lane{
+        static_cast<uint>(std::countr_zero(static_cast<uint>(write_mask)))};
+
+    const auto &level{rt.triangle.diffuse_texture->get_level(
+        select_mip_level(rt, glm::vec2{get_pos(lane) - tile.origin}))};
+
+    colour_vec = sample_bilinear<T>(level, u_vec, v_vec,
+                                    T::cast_to_ints(write_vec));
+  } else {
+    colour_vec = interpolate_colour<T>(vecs);
   }
 
-  SSE2::Array<float> interpolate_z_sse2(const std::array<__m128, 3> &bc_vecs);
+  if constexpr (IS_QUAD) {
+    alignas(SIMD_ALIGN_WIDTH) typename T::template Array<Colour> colours{};
+    T::store_ints(reinterpret_cast<int *>(colours.data()), colour_vec);
 
-  std::array<SSE2::Array<int>, 4>
-  interpolate_colour_sse2(const std::array<__m128, 3> &bc_vecs);
+    for (uint i{0}; i < T::LANE_WIDTH; i++)
+      if (is_writing_lane(i))
+        render_target.frame_buffer.set_pixel(get_pos(i), colours[i]);
+  } else {
+    render_target.frame_buffer.set_pixels_masked(lane_pos, colour_vec,
+                                                 T::cast_to_ints(write_vec));
+  }
+}
 
-  std::pair<SSE2::Array<int>, SSE2::Array<int>>
-  interpolate_texture_sse2(const std::array<__m128, 3> &bc_vecs);
+template <typename T>
+void PixelProcessor::process_depth(int y,
+                                   const typename T::IntVec &is_inside_vec,
+                                   int is_inside_mask,
+                                   const AttributeVecs<T> &vecs) {
 
-  void process_pixels_sse2(int y, int is_inside_mask,
-                           const std::array<__m128, 3> &bc_vecs);
+  if (is_inside_mask) {
+    const glm::ivec2 pos{x, y};
+    const auto mask_vec{T::cast_to_floats(is_inside_vec)};
 
-  void iterate_pixels_sse2(int y);
-  void iterate_pixels_sequentially_sse2(int y);
+#ifdef USING_SIMD_AVX2
+    if constexpr (std::is_same<T, AVX2>::value)
+      render_target.z_buffer.test_and_set_lane_avx2(pos, vecs.z, mask_vec);
+    else
 #endif
+      render_target.z_buffer.test_and_set_lane_sse2(pos, vecs.z, mask_vec);
 
-#ifdef USING_SIMD_AVX2
-  AVX2::Array<float>
-  interpolate_z_avx2(const std::array<__m256, 3> &bc_vec256s);
+    was_inside = true;
+  }
 
-  std::array<AVX2::Array<int>, 4>
-  interpolate_colour_avx2(const std::array<__m256, 3> &bc_vec256s);
+  // coverage is convex, so a row is done once it has been left
+  if (was_inside && !pixel_is_inside_mask(T::LANE_WIDTH - 1, is_inside_mask)) {
+    is_outside_right = true;
 
-  std::pair<AVX2::Array<int>, AVX2::Array<int>>
-  interpolate_texture_avx2(const std::array<__m256, 3> &bc_vec256s);
+    x = max_x;
+  }
+}
 
-  void process_pixels_avx2(int y, int is_inside_mask,
-                           const std::array<__m256, 3> &bc_vec256s);
+template <typename T>
+void PixelProcessor::iterate_pixels(
+    int y, const std::array<typename T::IntVec, 3> &delta_w_x_init_vecs,
+    const std::array<typename T::IntVec, 3> &delta_w_x_step_vecs) {
 
-  void iterate_pixels_avx2(int y);
-#endif
+  std::array<typename T::IntVec, 3> w_vecs{
+      T::set_int(SSE2::extract_int<0>(w_seq_vec)),
+      T::set_int(SSE2::extract_int<1>(w_seq_vec)),
+      T::set_int(SSE2::extract_int<2>(w_seq_vec))};
 
-public:
-  PixelProcessor(RenderTarget &render_target, const RenderTriangle &rt);
+  for (uint i{0}; i < w_vecs.size(); i++)
+    w_vecs[i] = T::add_ints(w_vecs[i], delta_w_x_init_vecs[i]);
 
-  void iterate_x(int y);
-  void step_y();
-};
+  AttributeVecs<T> vecs{};
+  AttributeVecs<T> step_vecs{};
+  init_attribute_vecs<T, false>(y, vecs, step_vecs);
+
+  for (; x < max_x - (T::LANE_WIDTH - 1); x += T::LANE_WIDTH) {
+    const auto is_inside_vec{
+        is_covered
+            ? T::minus_one_ints
+            : T::compare_ints_gt(T::or_ints(w_vecs), T::minus_one_ints)};
+
+    const auto is_inside_mask{T::move_mask_int8(is_inside_vec)};
+
+    if (pass == PASS_DEPTH)
+      process_depth<T>(y, is_inside_vec, is_inside_mask, vecs);
+    else
+      process_pixels<T>(y, is_inside_vec, is_inside_mask, vecs);
+
+    for (uint i{0}; !is_outside_right & (i < w_vecs.size()); i++)
+      w_vecs[i] = T::add_ints(w_vecs[i], delta_w_x_step_vecs[i]);
+
+    step_attribute_vecs<T>(vecs, step_vecs);
+  }
+
+  w_seq_vec = SSE2::set_ints(0, T::template extract_int<0>(w_vecs[2]),
+                             T::template extract_int<0>(w_vecs[1]),
+                             T::template extract_int<0>(w_vecs[0]));
+}
+
+template <typename T>
+void PixelProcessor::iterate_quads(
+    int y, const typename T::IntVec &quad_x_vec,
+    const std::array<typename T::IntVec, 3> &delta_w_quad_init_vecs,
+    const std::array<typename T::IntVec, 3> &delta_w_quad_step_vecs) {
+
+  // move_mask_int8 gives four bits per lane, so each row owns half the mask
+  constexpr auto ROW_MASK_BITS{T::LANE_WIDTH * 2};
+  constexpr auto ROW_MASK{(1 << ROW_MASK_BITS) - 1};
+
+  std::array<typename T::IntVec, 3> w_vecs{
+      T::set_int(SSE2::extract_int<0>(w_seq_vec)),
+      T::set_int(SSE2::extract_int<1>(w_seq_vec)),
+      T::set_int(SSE2::extract_int<2>(w_seq_vec))};
+
+  for (uint i{0}; i < w_vecs.size(); i++)
+    w_vecs[i] = T::add_ints(w_vecs[i], delta_w_quad_init_vecs[i]);
+
+  AttributeVecs<T> vecs{};
+  AttributeVecs<T> step_vecs{};
+  init_attribute_vecs<T, true>(y, vecs, step_vecs);
+
+  // coverage of each row is convex, so both rows are done once both have
+  // been entered and left
+  uint entered_rows{0};
+  uint left_rows{0};
+
+  for (; x < max_x && left_rows != 0b11; x += QUAD_WIDTH<T>) {
+    auto is_inside_vec{
+        is_covered
+            ? T::minus_one_ints
+            : T::compare_ints_gt(T::or_ints(w_vecs), T::minus_one_ints)};
+
+    if (x + QUAD_WIDTH<T> > max_x)
+      is_inside_vec =
+          T::and_ints(is_inside_vec,
+                      T::compare_ints_gt(T::set_int(max_x - x), quad_x_vec));
+
+    const auto is_inside_mask{T::move_mask_int8(is_inside_vec)};
+
+    for (uint row{0}; row < 2; row++) {
+      if ((is_inside_mask >> (row * ROW_MASK_BITS)) & ROW_MASK)
+        entered_rows |= 1 << row;
+      else if (entered_rows & (1 << row))
+        left_rows |= 1 << row;
+    }
+
+    if (is_inside_mask)
+      process_pixels<T, true>(y, is_inside_vec, is_inside_mask, vecs);
+
+    for (uint i{0}; i < w_vecs.size(); i++)
+      w_vecs[i] = T::add_ints(w_vecs[i], delta_w_quad_step_vecs[i]);
+
+    step_attribute_vecs<T>(vecs, step_vecs);
+  }
+}
+
+END_KERNELS
+#endif
 
 } // namespace Archa
@@ -3,62 +3,162 @@
 #include "config.hpp"
 
 #include <BS_thread_pool.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <atomic>
 #include <future>
 #include <glm/glm.hpp>
+#include <vector>
 
 #include "bin.hpp"
 #include "binner.hpp"
 #include "camera.hpp"
+#include "clipper.hpp"
+#include "frame_buffer.hpp"
+#include "render_pass.hpp"
 #include "render_target.hpp"
 #include "render_triangle.hpp"
 #include "scene.hpp"
 #include "triangle.hpp"
 #include "vertex.hpp"
+#include "vertex_cache.hpp"
 
 namespace Archa {
 
 class Rasteriser {
-  RenderTarget render_target{};
+  glm::ivec2 size{};
+
+  // the finished frame, which tiles are resolved into once rasterised
+  FrameBuffer frame_buffer{};
+  mutable sf::Texture texture{};
+
+  // one tile sized target per worker, which rasterises the bins it takes a
+  // tile at a time
+  std::vector<RenderTarget> tile_targets{};
+
+  // the next bin in binner's order for a worker to take; workers pull bins
+  // until none are left, so none idles while another still has a backlog
+  std::atomic<uint> next_bin{};
+
   Binner binner{};
 
+  Clipper clipper{};
+
   const Camera *camera{nullptr};
 
+  // rasterise depth and triangle ids first, then shade each pixel once
+  bool is_visibility_buffer_enabled{false};
+
+  // rasterise depth only first, then shade where the depth matches; ignored
+  // while the visibility buffer is enabled
+  bool is_depth_prepass_enabled{false};
+
+  // take bins by their cost last frame, most expensive first, so that an
+  // expensive bin is not left to start last; otherwise bins keep the order
+  // they are in
+  bool is_cost_ordering_enabled{true};
+
+  // chosen per view, e.g. 16 bit for low precision views
+  DepthFormat depth_format{DepthFormat::FLOAT32};
+
   glm::mat4 projection_transform{0};
   glm::mat4 screen_space_transform{1};
 
   std::vector<std::future<void>> futures{};
 
+  // scene indices of the model instances that survived frustum culling this
+  // frame, with their post-transform vertices running parallel to it
+  std::vector<uint> visible_instances{};
+  std::vector<VertexCache> vertex_caches{};
+
+  // visible instance index and meshlet index of every meshlet that survived
+  // frustum and cone culling this frame
+  std::vector<std::pair<uint, uint>> visible_meshlets{};
+
+  // first global triangle index of each visible meshlet, used to hand every
+  // geometry worker a contiguous range of the scene
+  std::vector<uint> triangle_offsets{};
+
+  // vertex index ranges of one instance's visible meshlets, merged before
+  // transforming
+  std::vector<std::pair<uint, uint>> vertex_ranges{};
+
   void compute_projection_transform();
   void compute_screen_space_transform();
 
-  void clear_bin(const Bin &bin);
+  float get_depth(const glm::vec4 &clip) const;
 
-public:
-  void resize_bins(int bin_count);
+  // shades the pixels of the tile [tile_min, tile_max) that the visibility
+  // pass left a triangle id in
+  void shade_tile(RenderTarget &target, uint bin_index,
+                  const glm::ivec2 &tile_min, const glm::ivec2 &tile_max);
+
+  // sorts a bin's triangles, then rasterises and resolves it a tile at a time
+  void render_bin(RenderTarget &target, uint bin_index,
+                  const std::vector<RenderPass> &passes);
 
-  void create(const glm::ivec2 &size, int bin_count);
+  // one worker's loop, rendering bins until there are none left and timing
+  // each for the next frame's order
+  void render_bins(RenderTarget &target, const std::vector<RenderPass> &passes);
+
+  void bin_triangle(uint queue_index, uint bin_index,
+                    RenderTriangle &render_triangle);
+
+public:
+  void create(const glm::ivec2 &size);
 
   void set_camera(const Camera *camera);
+  void set_visibility_buffer_enabled(bool is_enabled);
+  void set_depth_prepass_enabled(bool is_enabled);
+  void set_cost_ordering_enabled(bool is_enabled);
 
+  // takes effect from the next frame; the adaptive layout gives each worker
+  // one bin, and suits views that change little from frame to frame
+  void set_bin_layout(BinLayout layout);
+
+  // clears the tile depth buffers when they already exist
+  void set_depth_format(DepthFormat format);
+
+  // bins four boxes at a time from i, leaving i at the first box left;
+  // defined in rasteriser_avx2.cpp
 #ifdef USING_SIMD_AVX2
-  void
+  AVX2_TARGET void
   iterate_boxes_avx2(const BoundingBox &box,
                      const std::vector<std::pair<uint, BoundingBox>> &boxes,
                      const std::array<int, 3> &w_row,
                      const std::array<glm::ivec2, 3> &delta_w, uint &i,
-                     RenderTriangle &render_triangle);
+                     uint queue_index, RenderTriangle &render_triangle);
 #endif
 
   void iterate_boxes(const BoundingBox &box,
                      const std::vector<std::pair<uint, BoundingBox>> &boxes,
                      const std::array<int, 3> &w_row,
                      const std::array<glm::ivec2, 3> &delta_w, uint i,
-                     RenderTriangle &render_triangle);
+                     uint queue_index, RenderTriangle &render_triangle);
+
+  void setup_triangle(const Triangle &triangle,
+                      const std::array<Colour, 3> &colours,
+                      const std::array<glm::vec4, 3> &clip,
+                      const std::array<glm::ivec2, 3> &v, uint queue_index);
+
+  void process_clipped_triangle(const std::vector<Vertex> &vertices,
+                                const VertexCache &vertex_cache,
+                                const Triangle &triangle, uint8 planes,
+                                uint queue_index);
+
+  void process_triangle(const std::vector<Vertex> &vertices,
+                        const VertexCache &vertex_cache,
+                        const Triangle &triangle, uint queue_index);
+
+  void transform_vertices(const Model &model, uint visible_index,
+                          const glm::mat4 &vp, uint first, uint last,
+                          BS::thread_pool &thread_pool);
 
-  void process_triangle(const std::vector<Vertex> &vertices, Triangle triangle,
-                        const glm::mat4 &transform);
+  void process_triangles(const Scene &scene, uint queue_index,
+                         uint first_triangle, uint last_triangle);
 
-  void render_triangle(RenderTriangle &rt);
+  // tile must already be in the target's coordinates, with its box inside it
+  void render_triangle(RenderTarget &target, const TileTriangle &tile,
+                       RenderPass pass);
   void render_scene(const Scene &scene, BS::thread_pool &thread_pool);
 
   const sf::Texture &get_texture() const;
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "config.hpp"
+
+#include "types.hpp"
+
+namespace Archa {
+
+// what rasterising a triangle writes for each pixel passing the depth test
+enum RenderPass : uint8 {
+  // shaded colour and depth
+  PASS_COLOUR,
+
+  // depth and the triangle's id in the visibility buffer, shaded later
+  PASS_VISIBILITY,
+
+  // depth only, ahead of PASS_COLOUR_EQUAL
+  PASS_DEPTH,
+
+  // shaded colour where the depth matches the pre-pass, leaving depth as is
+  PASS_COLOUR_EQUAL
+};
+
+inline bool passes_depth_test(RenderPass pass, float z, float stored_z) {
+  return pass == PASS_COLOUR_EQUAL ? z == stored_z : z < stored_z;
+}
+
+} // namespace Archa
@@ -2,26 +2,44 @@
 
 #include "config.hpp"
 
-#include <SFML/Graphics/Texture.hpp>
 #include <glm/glm.hpp>
 
+#include "colour.hpp"
 #include "frame_buffer.hpp"
+#include "visibility_buffer.hpp"
 #include "z_buffer.hpp"
 
 namespace Archa {
 
+// the buffers a tile is rasterised into before it is resolved to the frame;
+// small enough that its colour, depth and ids stay in cache throughout
 struct RenderTarget {
+  static constexpr int TILE_SIZE{64};
+
   glm::ivec2 size{};
 
   FrameBuffer frame_buffer{};
   ZBuffer z_buffer{};
+  VisibilityBuffer visibility_buffer{};
+
+  void create(const glm::ivec2 &size, DepthFormat depth_format);
 
-  void create(const glm::ivec2 &size);
+  // clears the target to colour and the far depth lazily, one depth buffer
+  // block at a time
+  void clear(const Colour &colour);
 
-  const sf::Texture &blit() const;
+  // writes the pending clears of the blocks overlapping [min, max), which
+  // must happen before they are first drawn to
+  void resolve_clears(const glm::ivec2 &min, const glm::ivec2 &max);
+
+  // writes the clear colour of blocks that were never drawn to; their depth
+  // is left unwritten, as nothing reads it before the next clear
+  void resolve_colour_clears();
 
 private:
-  mutable sf::Texture texture{};
+  Colour clear_colour{};
+
+  void fill_block(const glm::ivec2 &pos);
 };
 
 } // namespace Archa
@@ -5,22 +5,65 @@
 #include <array>
 
 #include "bounding_box.hpp"
-#include "colour.hpp"
+#include "constants.hpp"
 #include "triangle.hpp"
 
 namespace Archa {
 
+// an attribute's value a * x + b * y + c at the centre of the pixel (x, y)
+// pixels from the triangle's origin
+struct AttributePlane {
+  float a{};
+  float b{};
+  float c{};
+
+  float get(const glm::vec2 &offset) const {
+    return a * offset.x + b * offset.y + c;
+  }
+};
+
 struct RenderTriangle {
   Triangle triangle{};
-  std::array<Colour, 3> colours{};
   BoundingBox box{};
-  int area{};
-  std::array<int8, 3> bias{};
+
+  // edge functions at pixel centres, in sub-pixel units with the top-left
+  // rule already applied, so a pixel is covered when all three are >= 0
   std::array<int, 3> w_row{};
-  std::array<glm::vec4, 3> clip{};
   std::array<glm::ivec2, 3> delta_w{};
+
+  // set up once per triangle, so pixels only evaluate or step them; texture
+  // coordinates and 1 / w are divided by w, leaving one reciprocal per pixel
+  // for perspective correction
+  //
+  // planes are relative to origin, the min corner of the whole triangle's
+  // box, which stays put while box is clipped to each bin and only moves
+  // into a tile's coordinates in the triangle's TileTriangle
+  glm::ivec2 origin{};
+  AttributePlane z_plane{};
+  AttributePlane inv_w_plane{};
+  std::array<AttributePlane, 2> uv_over_w_planes{};
+  std::array<AttributePlane, RGBA_CHANNEL_COUNT> colour_planes{};
+
+  // nearest vertex depth, which no interpolated depth gets nearer than
+  float min_z{};
+
+  // small and sliver triangles are traversed two rows at a time
+  bool is_quad_traversal{};
+
+  // packed by VisibilityBuffer::pack_id once the triangle is binned
+  uint32 id{};
 };
 
 using RenderTriangleGroups = std::vector<std::vector<RenderTriangle>>;
 
+// a binned triangle clipped to one tile and moved into the tile's
+// coordinates; only the fields that change per tile are kept here, the rest
+// are read from the bin's triangle
+struct TileTriangle {
+  const RenderTriangle *triangle{};
+  BoundingBox box{};
+  std::array<int, 3> w_row{};
+  glm::ivec2 origin{};
+};
+
 } // namespace Archa
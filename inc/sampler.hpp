@@ -0,0 +1,180 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <tuple>
+#include <type_traits>
+
+#include "block_compression.hpp"
+#include "colour.hpp"
+#include "image.hpp"
+#include "intrinsics.hpp"
+
+namespace Archa {
+
+// bilinear sample of a mip level at normalised uv, repeating the texture
+// outside [0, 1)
+Colour sample_bilinear(const MipLevel &level, const glm::vec2 &uv);
+
+// the lane kernels, compiled only by the *_sse2.cpp and *_avx2.cpp files, for
+// their instruction set
+#ifdef BEGIN_KERNELS
+BEGIN_KERNELS
+
+// vector form of MipLevel::get_index
+template <typename T>
+typename T::IntVec get_texel_indices(const MipLevel &level,
+                                     const typename T::IntVec &x_vec,
+                                     const typename T::IntVec &y_vec) {
+
+  const auto tile_mask_vec{T::set_int(MipLevel::TILE_SIZE - 1)};
+
+  const auto tile_vec{T::add_ints(
+      T::multiply_ints(T::shift_right_ints(y_vec, MipLevel::TILE_SHIFT),
+                       T::set_int(level.tile_columns)),
+      T::shift_right_ints(x_vec, MipLevel::TILE_SHIFT))};
+
+  const auto texel_vec{T::add_ints(
+      T::shift_left_ints(T::and_ints(y_vec, tile_mask_vec),
+                         MipLevel::TILE_SHIFT),
+      T::and_ints(x_vec, tile_mask_vec))};
+
+  return T::add_ints(T::shift_left_ints(tile_vec, MipLevel::TILE_SHIFT * 2),
+                     texel_vec);
+}
+
+// packed RGBA texels at (x, y) for the lanes set in mask_vec; AVX2 gathers
+// them in one instruction, while compressed levels read each lane through
+// the decoded tile cache
+template <typename T>
+typename T::IntVec gather_texels(const MipLevel &level,
+                                 const typename T::IntVec &x_vec,
+                                 const typename T::IntVec &y_vec,
+                                 const typename T::IntVec &mask_vec) {
+
+  const auto index_vec{get_texel_indices<T>(level, x_vec, y_vec)};
+
+  const auto is_compressed{level.format != TextureFormat::RGBA8};
+  const auto *texels{reinterpret_cast<const int *>(level.texels.data())};
+
+#ifdef USING_SIMD_AVX2
+  if constexpr (std::is_same<T, AVX2>::value)
+    if (!is_compressed)
+      return AVX2::mask_gather_ints(texels, index_vec, mask_vec);
+#endif
+
+  alignas(SIMD_ALIGN_WIDTH) typename T::template Array<int> indices{};
+  alignas(SIMD_ALIGN_WIDTH) typename T::template Array<int> colours{};
+
+  T::store_ints(indices.data(), index_vec);
+
+  const auto mask{T::move_mask_float(T::cast_to_floats(mask_vec))};
+
+  for (uint i{0}; i < T::LANE_WIDTH; i++) {
+    if (!((mask >> i) & 1))
+      continue;
+
+    const auto index{static_cast<uint>(indices[i])};
+
+    if (is_compressed) {
+      const auto *tile{get_decoded_tile(level, index / BLOCK_TEXEL_COUNT)};
+
+      colours[i] = static_cast<int>(tile[index % BLOCK_TEXEL_COUNT]);
+    } else {
+      colours[i] = texels[index];
+    }
+  }
+
+  return T::load_ints(colours.data());
+}
+
+// texel coordinates of the two taps either side of t along one axis, wrapped
+// into [0, size), with the weight of the second tap
+template <typename T>
+std::tuple<typename T::IntVec, typename T::IntVec, typename T::FloatVec>
+get_tap_coords(const typename T::FloatVec &t_vec, int size) {
+  const auto size_vec{T::set_int(size)};
+
+  auto coord_vec{T::subtract_floats(t_vec, T::floor_floats(t_vec))};
+
+  coord_vec = T::subtract_floats(
+      T::multiply_floats(coord_vec, T::convert_to_floats(size_vec)),
+      T::set_float(0.5f));
+
+  const auto floor_vec{T::floor_floats(coord_vec)};
+  const auto weight_vec{T::subtract_floats(coord_vec, floor_vec)};
+
+  auto coord0_vec{T::convert_to_ints(floor_vec)};
+  auto coord1_vec{T::add_ints(coord0_vec, T::set_int(1))};
+
+  coord0_vec = T::add_ints(
+      coord0_vec,
+      T::and_ints(T::compare_ints_gt(T::set_zero_int(), coord0_vec), size_vec));
+
+  coord1_vec = T::subtract_ints(
+      coord1_vec, T::and_ints(T::compare_ints_gt(coord1_vec,
+                                                 T::set_int(size - 1)),
+                              size_vec));
+
+  return {coord0_vec, coord1_vec, weight_vec};
+}
+
+// bilinear sample of the lanes set in mask_vec, as packed RGBA
+template <typename T>
+typename T::IntVec sample_bilinear(const MipLevel &level,
+                                   const typename T::FloatVec &u_vec,
+                                   const typename T::FloatVec &v_vec,
+                                   const typename T::IntVec &mask_vec) {
+
+  const auto [x0_vec, x1_vec, weight_x_vec]{
+      get_tap_coords<T>(u_vec, level.size.x)};
+
+  const auto [y0_vec, y1_vec, weight_y_vec]{
+      get_tap_coords<T>(v_vec, level.size.y)};
+
+  const std::array<typename T::IntVec, 4> texel_vecs{
+      gather_texels<T>(level, x0_vec, y0_vec, mask_vec),
+      gather_texels<T>(level, x1_vec, y0_vec, mask_vec),
+      gather_texels<T>(level, x0_vec, y1_vec, mask_vec),
+      gather_texels<T>(level, x1_vec, y1_vec, mask_vec)};
+
+  const auto channel_mask_vec{T::set_int(0xFF)};
+
+  const auto get_channel{[&](uint texel, uint c) {
+    return T::convert_to_floats(T::and_ints(
+        T::shift_right_ints(texel_vecs[texel], static_cast<int>(c * 8)),
+        channel_mask_vec));
+  }};
+
+  const auto lerp{[](const auto &a_vec, const auto &b_vec,
+                     const auto &weight_vec) {
+    const auto delta_vec{T::subtract_floats(b_vec, a_vec)};
+
+    return T::add_floats(a_vec, T::multiply_floats(delta_vec, weight_vec));
+  }};
+
+  auto colour_vec{T::set_zero_int()};
+
+  for (uint c{0}; c < RGBA_CHANNEL_COUNT; c++) {
+    const auto top_vec{
+        lerp(get_channel(0, c), get_channel(1, c), weight_x_vec)};
+
+    const auto bottom_vec{
+        lerp(get_channel(2, c), get_channel(3, c), weight_x_vec)};
+
+    const auto channel_vec{
+        T::convert_to_ints(lerp(top_vec, bottom_vec, weight_y_vec))};
+
+    colour_vec = T::or_ints(
+        colour_vec, T::shift_left_ints(channel_vec, static_cast<int>(c * 8)));
+  }
+
+  return colour_vec;
+}
+
+END_KERNELS
+#endif
+
+} // namespace Archa
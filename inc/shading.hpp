@@ -0,0 +1,25 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <glm/glm.hpp>
+
+#include "colour.hpp"
+#include "render_triangle.hpp"
+
+namespace Archa {
+
+// offsets are in pixels from the triangle box's min corner
+
+// perspective correct texture coordinates at a pixel
+glm::vec2 interpolate_uv(const RenderTriangle &rt, const glm::vec2 &offset);
+
+// mip level whose texels are closest to a pixel in size, from the screen
+// space derivatives of the texture coordinates there
+uint select_mip_level(const RenderTriangle &rt, const glm::vec2 &offset);
+
+// colour of a triangle at a pixel, with textures sampled perspective
+// correctly
+Colour shade_pixel(const RenderTriangle &rt, const glm::vec2 &offset);
+
+} // namespace Archa
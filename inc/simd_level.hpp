@@ -0,0 +1,30 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <optional>
+#include <string_view>
+
+#include "types.hpp"
+
+namespace Archa {
+
+// instruction sets the raster kernels can run with, in increasing order
+enum class SimdLevel : uint8 { NONE, SSE2, AVX2 };
+
+// highest level this build has kernels for; the rest of the build only
+// assumes the x86-64 baseline
+SimdLevel get_compiled_simd_level();
+
+// highest level the running CPU supports, from cpuid
+SimdLevel get_cpu_simd_level();
+
+// level the raster kernels dispatch on; starts at the highest level both the
+// build and the CPU support and may be lowered at runtime to compare paths
+SimdLevel get_simd_level();
+void set_simd_level(SimdLevel level);
+
+const char *to_string(SimdLevel level);
+std::optional<SimdLevel> parse_simd_level(std::string_view name);
+
+} // namespace Archa
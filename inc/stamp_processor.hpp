@@ -0,0 +1,96 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+
+#include "intrinsics.hpp"
+#include "render_pass.hpp"
+#include "render_target.hpp"
+#include "render_triangle.hpp"
+
+namespace Archa {
+
+// renders triangles whose box fits in a single stamp, testing coverage for
+// the whole stamp at once instead of setting up a PixelProcessor
+class StampProcessor {
+  RenderTarget &render_target;
+
+  void process_pixel(const TileTriangle &tile, RenderPass pass,
+                     const glm::ivec2 &pos);
+
+public:
+  static constexpr int SIZE{4};
+  static constexpr int PIXEL_COUNT{SIZE * SIZE};
+
+  explicit StampProcessor(RenderTarget &render_target);
+
+  static bool fits(const BoundingBox &box);
+
+  void render(const TileTriangle &tile, RenderPass pass);
+
+private:
+  using StampInts = std::array<int, PIXEL_COUNT>;
+
+  // pixel offsets of each lane within the stamp, row by row
+  alignas(SIMD_ALIGN_WIDTH) static constexpr StampInts STAMP_X{
+      0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3};
+
+  alignas(SIMD_ALIGN_WIDTH) static constexpr StampInts STAMP_Y{
+      0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+
+#ifdef USING_SIMD_SSE2
+  // stores a value per pixel that is negative where the pixel is outside the
+  // triangle or its box
+  template <typename T>
+  static void compute_coverage(const TileTriangle &tile, uint i,
+                               StampInts &coverage);
+
+  // computes the coverage of the lanes from pixel i to the end of the stamp,
+  // returning PIXEL_COUNT; defined in stamp_processor_sse2.cpp and
+  // stamp_processor_avx2.cpp
+  SSE2_TARGET static uint compute_coverage_sse2(const TileTriangle &tile,
+                                                uint i, StampInts &coverage);
+#endif
+
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET static uint compute_coverage_avx2(const TileTriangle &tile,
+                                                uint i, StampInts &coverage);
+#endif
+};
+
+#ifdef BEGIN_KERNELS
+BEGIN_KERNELS
+
+template <typename T>
+void StampProcessor::compute_coverage(const TileTriangle &tile, uint i,
+                                      StampInts &coverage) {
+  const auto &rt{*tile.triangle};
+
+  const auto stamp_x_vec{T::load_ints(&STAMP_X[i])};
+  const auto stamp_y_vec{T::load_ints(&STAMP_Y[i])};
+
+  const auto box_size{tile.box.max - tile.box.min};
+
+  auto coverage_vec{T::or_ints(
+      T::subtract_ints(T::set_int(box_size.x - 1), stamp_x_vec),
+      T::subtract_ints(T::set_int(box_size.y - 1), stamp_y_vec))};
+
+  for (uint j{0}; j < rt.delta_w.size(); j++) {
+    const auto &delta_w{rt.delta_w[j]};
+
+    const auto w_vec{T::add_ints(
+        T::set_int(tile.w_row[j]),
+        T::add_ints(T::multiply_ints(T::set_int(delta_w.x), stamp_x_vec),
+                    T::multiply_ints(T::set_int(delta_w.y), stamp_y_vec)))};
+
+    coverage_vec = T::or_ints(coverage_vec, w_vec);
+  }
+
+  T::store_ints(&coverage[i], coverage_vec);
+}
+
+END_KERNELS
+#endif
+
+} // namespace Archa
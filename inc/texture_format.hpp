@@ -0,0 +1,26 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <optional>
+#include <string_view>
+
+#include "types.hpp"
+
+namespace Archa {
+
+// how mip levels store their texels; BC1 packs each 4x4 tile into 8 bytes
+// with 1-bit alpha, BC3 into 16 bytes with an interpolated alpha block
+enum class TextureFormat : uint8 { RGBA8, BC1, BC3 };
+
+// format images are converted to as they load, RGBA8 unless overridden
+TextureFormat get_texture_format();
+void set_texture_format(TextureFormat format);
+
+// bytes per 4x4 block, 0 for RGBA8
+uint get_block_size(TextureFormat format);
+
+const char *to_string(TextureFormat format);
+std::optional<TextureFormat> parse_texture_format(std::string_view name);
+
+} // namespace Archa
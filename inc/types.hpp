@@ -10,6 +10,9 @@ using uint = unsigned int;
 using uint8 = uint8_t;
 
 using int8 = int8_t;
+using uint16 = uint16_t;
 using uint32 = uint32_t;
+using int64 = int64_t;
+using uint64 = uint64_t;
 
 } // namespace Archa
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "aligned_vector.hpp"
+#include "clipper.hpp"
+#include "intrinsics.hpp"
+#include "types.hpp"
+#include "vertex.hpp"
+
+namespace Archa {
+
+class VertexCache {
+  AlignedVector<float, SIMD_ALIGN_WIDTH> clip_x{};
+  AlignedVector<float, SIMD_ALIGN_WIDTH> clip_y{};
+  AlignedVector<float, SIMD_ALIGN_WIDTH> clip_z{};
+  AlignedVector<float, SIMD_ALIGN_WIDTH> clip_w{};
+
+  AlignedVector<int, SIMD_ALIGN_WIDTH> screen_x{};
+  AlignedVector<int, SIMD_ALIGN_WIDTH> screen_y{};
+
+  std::vector<uint8> outcodes{};
+
+  void transform_single(const std::vector<Vertex> &vertices,
+                        const glm::mat4 &vp,
+                        const glm::mat4 &screen_space_transform, uint i);
+
+  // the lane kernels, defined after the class for vertex_cache_sse2.cpp and
+  // vertex_cache_avx2.cpp alone, which compile them for their instruction set
+#ifdef USING_SIMD_SSE2
+  template <typename T>
+  static std::array<std::array<typename T::FloatVec, 4>, 4>
+  set_matrix(const glm::mat4 &matrix);
+
+  template <typename T>
+  static std::array<typename T::FloatVec, 4> multiply_matrix(
+      const std::array<std::array<typename T::FloatVec, 4>, 4> &matrix_vecs,
+      const std::array<typename T::FloatVec, 4> &vecs);
+
+  template <typename T>
+  static void transform_lanes(
+      const std::vector<Vertex> &vertices,
+      const std::array<std::array<typename T::FloatVec, 4>, 4> &vp_vecs,
+      const std::array<std::array<typename T::FloatVec, 4>, 4> &screen_vecs,
+      uint i, float *clip_x, float *clip_y, float *clip_z, float *clip_w,
+      int *screen_x, int *screen_y);
+
+  // transforms whole lanes from i up to last, returning the index they
+  // stopped at
+  SSE2_TARGET uint
+  transform_lanes_sse2(const std::vector<Vertex> &vertices, const glm::mat4 &vp,
+                       const glm::mat4 &screen_space_transform, uint i,
+                       uint last);
+#endif
+
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET uint
+  transform_lanes_avx2(const std::vector<Vertex> &vertices, const glm::mat4 &vp,
+                       const glm::mat4 &screen_space_transform, uint i,
+                       uint last);
+#endif
+
+public:
+  void resize(uint count);
+
+  // first must be a multiple of the widest SIMD lane
+  void transform(const std::vector<Vertex> &vertices, const glm::mat4 &vp,
+                 const glm::mat4 &screen_space_transform,
+                 const Clipper &clipper, uint first, uint last);
+
+  glm::vec4 get_clip(uint i) const;
+  glm::ivec2 get_screen(uint i) const;
+  uint8 get_outcode(uint i) const;
+};
+
+#ifdef BEGIN_KERNELS
+BEGIN_KERNELS
+
+template <typename T>
+std::array<std::array<typename T::FloatVec, 4>, 4>
+VertexCache::set_matrix(const glm::mat4 &matrix) {
+  std::array<std::array<typename T::FloatVec, 4>, 4> matrix_vecs{};
+
+  for (uint c{0}; c < 4; c++)
+    for (uint r{0}; r < 4; r++)
+      matrix_vecs[c][r] =
+          T::set_float(matrix[static_cast<int>(c)][static_cast<int>(r)]);
+
+  return matrix_vecs;
+}
+
+template <typename T>
+std::array<typename T::FloatVec, 4> VertexCache::multiply_matrix(
+    const std::array<std::array<typename T::FloatVec, 4>, 4> &matrix_vecs,
+    const std::array<typename T::FloatVec, 4> &vecs) {
+
+  std::array<typename T::FloatVec, 4> result_vecs{};
+
+  for (uint r{0}; r < 4; r++) {
+    result_vecs[r] = T::multiply_floats(matrix_vecs[0][r], vecs[0]);
+
+    for (uint c{1}; c < 4; c++)
+      result_vecs[r] = T::add_floats(
+          result_vecs[r], T::multiply_floats(matrix_vecs[c][r], vecs[c]));
+  }
+
+  return result_vecs;
+}
+
+template <typename T>
+void VertexCache::transform_lanes(
+    const std::vector<Vertex> &vertices,
+    const std::array<std::array<typename T::FloatVec, 4>, 4> &vp_vecs,
+    const std::array<std::array<typename T::FloatVec, 4>, 4> &screen_vecs,
+    uint i, float *clip_x, float *clip_y, float *clip_z, float *clip_w,
+    int *screen_x, int *screen_y) {
+
+  alignas(SIMD_ALIGN_WIDTH) std::array<typename T::template Array<float>, 3>
+      positions{};
+
+  for (uint j{0}; j < T::LANE_WIDTH; j++) {
+    const auto &vertex{vertices[i + j]};
+
+    positions[0][j] = vertex.x;
+    positions[1][j] = vertex.y;
+    positions[2][j] = vertex.z;
+  }
+
+  const std::array<typename T::FloatVec, 4> position_vecs{
+      T::load_floats(positions[0].data()),
+      T::load_floats(positions[1].data()),
+      T::load_floats(positions[2].data()), T::set_float(1.0f)};
+
+  const auto clip_vecs{multiply_matrix<T>(vp_vecs, position_vecs)};
+  const auto screen_vecs_result{multiply_matrix<T>(screen_vecs, clip_vecs)};
+
+  T::store_floats(clip_x + i, clip_vecs[0]);
+  T::store_floats(clip_y + i, clip_vecs[1]);
+  T::store_floats(clip_z + i, clip_vecs[2]);
+  T::store_floats(clip_w + i, clip_vecs[3]);
+
+  T::store_ints(screen_x + i,
+                T::convert_to_ints(T::divide_floats(screen_vecs_result[0],
+                                                    screen_vecs_result[3])));
+
+  T::store_ints(screen_y + i,
+                T::convert_to_ints(T::divide_floats(screen_vecs_result[1],
+                                                    screen_vecs_result[3])));
+}
+
+END_KERNELS
+#endif
+
+} // namespace Archa
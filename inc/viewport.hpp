@@ -30,6 +30,13 @@ public:
   void set_camera(const Camera &camera);
   void set_scene(const Scene &scene);
 
+  // raster options, which may be set before or after create
+  void set_visibility_buffer_enabled(bool is_enabled);
+  void set_depth_prepass_enabled(bool is_enabled);
+  void set_cost_ordering_enabled(bool is_enabled);
+  void set_depth_format(DepthFormat format);
+  void set_bin_layout(BinLayout layout);
+
   void render();
 
   const sf::Texture &get_texture() const;
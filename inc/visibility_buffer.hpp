@@ -0,0 +1,40 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <glm/glm.hpp>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Archa {
+
+// per pixel id of the binned triangle nearest the camera, packed from the
+// geometry queue it was binned by and its index in that queue's bin group
+class VisibilityBuffer {
+  glm::ivec2 size{};
+  std::vector<uint32> ids{};
+
+public:
+  static constexpr uint32 NO_ID{std::numeric_limits<uint32>::max()};
+
+  static constexpr uint QUEUE_BITS{8};
+  static constexpr uint TRIANGLE_BITS{32 - QUEUE_BITS};
+
+  // the last triangle index is left unused, so that no id packs to NO_ID
+  static constexpr uint MAX_QUEUE_COUNT{1u << QUEUE_BITS};
+  static constexpr uint MAX_TRIANGLE_INDEX{(1u << TRIANGLE_BITS) - 2};
+
+  static uint32 pack_id(uint queue_index, uint triangle_index);
+  static std::pair<uint, uint> unpack_id(uint32 id);
+
+  void create(const glm::ivec2 &size);
+  void clear(const glm::ivec2 &min, const glm::ivec2 &max);
+
+  void set(const glm::ivec2 &pos, uint32 id);
+  uint32 get(const glm::ivec2 &pos) const;
+};
+
+} // namespace Archa
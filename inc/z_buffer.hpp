@@ -3,32 +3,371 @@
 #include "config.hpp"
 
 #include <aligned_vector.hpp>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "bounding_box.hpp"
+#include "intrinsics.hpp"
+#include "types.hpp"
 
 namespace Archa {
 
+// how ZBuffer stores depth; the fixed-point formats trade precision for
+// bandwidth, while reversed-Z runs from 1 at the near plane to 0 at the far
+// plane, where floats are precise enough to even out perspective
+enum class DepthFormat : uint8 { FLOAT32, UNORM16, UNORM24, FLOAT32_REVERSED };
+
+const char *to_string(DepthFormat format);
+std::optional<DepthFormat> parse_depth_format(std::string_view name);
+
+// depths come in and go out as floats where smaller is nearer, and are only
+// converted to the format as they are stored; reversed-Z depths are passed
+// negated to keep that order
 class ZBuffer {
   glm::ivec2 size{};
-  AlignedVector<float, SIMD_ALIGN_WIDTH> data{};
+  DepthFormat format{};
+
+  // only the array holding format's values is allocated; UNORM24 keeps each
+  // depth in the low bits of a uint32
+  AlignedVector<float, SIMD_ALIGN_WIDTH> float_data{};
+  AlignedVector<uint16, SIMD_ALIGN_WIDTH> uint16_data{};
+  AlignedVector<uint32, SIMD_ALIGN_WIDTH> uint32_data{};
+
+  // 2^bits for the fixed-point formats
+  float fixed_point_scale{};
+
+  // farthest depth stored in each block, recomputed lazily once a write has
+  // left it dirty
+  glm::ivec2 block_count{};
+  std::vector<float> block_max{};
+  std::vector<uint8> block_is_dirty{};
+
+  // blocks cleared without being written, which still hold stale depths
+  // until resolve_clear
+  std::vector<uint8> block_is_clear_pending{};
+
+  uint get_index(const glm::ivec2 &pos) const;
+  uint get_block_index(const glm::ivec2 &pos) const;
+  void mark_blocks_dirty(const glm::ivec2 &pos, int width);
+  float get_block_max(uint block_index);
+
+  bool is_fixed_point() const;
+  uint32 encode_fixed_point(float z) const;
+  float decode_fixed_point(uint32 value) const;
+
+  // the depth a cleared pixel reads back as
+  float get_clear_depth() const;
+
+  // the lane kernels, defined after the class for the *_sse2.cpp and
+  // *_avx2.cpp files alone, which compile them for their instruction set
+#ifdef USING_SIMD_SSE2
+  template <typename T>
+  static typename T::FloatVec negate_floats(const typename T::FloatVec &vec);
+
+  template <typename T>
+  typename T::IntVec
+  encode_fixed_point_lane(const typename T::FloatVec &z_vec) const;
+
+  template <typename T>
+  typename T::FloatVec
+  decode_fixed_point_lane(const typename T::IntVec &value_vec) const;
+
+  template <typename T> typename T::IntVec load_fixed_point_lane(uint i) const;
+
+  template <typename T>
+  void store_fixed_point_lane(uint i, const typename T::IntVec &value_vec);
+
+  template <typename T> void clear_lane(int i);
+
+  template <typename T>
+  int test_and_set_lane(const glm::ivec2 &pos,
+                        const typename T::FloatVec &z_vec,
+                        const typename T::FloatVec &mask_vec);
+
+  template <typename T>
+  typename T::FloatVec get_lane(const glm::ivec2 &pos) const;
+
+  template <typename T>
+  void set_lane(const glm::ivec2 &pos, const typename T::FloatVec &z_vec,
+                const typename T::FloatVec &mask_vec);
+
+  template <typename T>
+  typename T::FloatVec quantise_lane(const typename T::FloatVec &z_vec) const;
+
+  // clears the whole lanes of the count pixels from index i, returning how
+  // many pixels they covered
+  SSE2_TARGET int clear_lanes_sse2(int i, int count);
+#endif
+
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET int clear_lanes_avx2(int i, int count);
+
+  // farthest depth in the lane at pos of each row up to max_y
+  AVX2_TARGET float get_rows_max_avx2(const glm::ivec2 &pos, int max_y) const;
+#endif
 
 public:
-  void create(const glm::ivec2 &size);
+  static constexpr int BLOCK_SIZE{8};
+
+  void create(const glm::ivec2 &size, DepthFormat format);
+
+  DepthFormat get_format() const;
+
+  // z rounded to the precision it is stored at, so that depth tests against
+  // stored values, including equality, agree with the tests made as they
+  // were written
+  float quantise(float z) const;
+
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET __m256 quantise_lane_avx2(const __m256 &z_vec) const;
+#endif
+
+#ifdef USING_SIMD_SSE2
+  SSE2_TARGET __m128 quantise_lane_sse2(const __m128 &z_vec) const;
+#endif
+
+  // marks the blocks as cleared without writing them, so each must be
+  // resolved before it is first drawn to; blocks must not straddle the edges
+  // of the cleared area
+  void clear_blocks(const glm::ivec2 &min, const glm::ivec2 &max);
+
+  bool is_clear_pending(const glm::ivec2 &pos) const;
+
+  // writes the clear depth over the pending block holding pos
+  void resolve_clear(const glm::ivec2 &pos);
+
+  // true when z is behind every block the box touches
+  bool is_occluded(const BoundingBox &box, float z);
+
+  // pixel span of the blocks in y's block row that z may still be in front
+  // of, clipped to [min_x, max_x); empty when first >= second
+  std::pair<int, int> find_visible_span(int y, int min_x, int max_x,
+                                        float z);
 
   void clear_single(int i);
 
+  // depth test a lane of pixels starting at pos, writing the nearer depths
+  // where mask is set; returns the move mask of the lanes written
 #ifdef USING_SIMD_AVX2
-  void clear_lane_avx2(int i);
+  AVX2_TARGET int test_and_set_lane_avx2(const glm::ivec2 &pos,
+                                         const __m256 &z_vec,
+                                         const __m256 &mask_vec);
 #endif
 
 #ifdef USING_SIMD_SSE2
-  void clear_lane_sse2(int i);
+  SSE2_TARGET int test_and_set_lane_sse2(const glm::ivec2 &pos,
+                                         const __m128 &z_vec,
+                                         const __m128 &mask_vec);
 #endif
 
-  // void clear();
+  // a lane of depths starting at pos, and a write of the lanes set in mask
+#ifdef USING_SIMD_AVX2
+  AVX2_TARGET __m256 get_lane_avx2(const glm::ivec2 &pos) const;
+  AVX2_TARGET void set_lane_avx2(const glm::ivec2 &pos, const __m256 &z_vec,
+                                 const __m256 &mask_vec);
+#endif
+
+#ifdef USING_SIMD_SSE2
+  SSE2_TARGET __m128 get_lane_sse2(const glm::ivec2 &pos) const;
+  SSE2_TARGET void set_lane_sse2(const glm::ivec2 &pos, const __m128 &z_vec,
+                                 const __m128 &mask_vec);
+#endif
 
   void set(const glm::ivec2 &pos, float value);
   float get(const glm::ivec2 &pos) const;
 };
 
+#ifdef BEGIN_KERNELS
+BEGIN_KERNELS
+
+template <typename T>
+typename T::FloatVec ZBuffer::negate_floats(const typename T::FloatVec &vec) {
+  return T::subtract_floats(T::set_zero_float(), vec);
+}
+
+template <typename T>
+typename T::IntVec
+ZBuffer::encode_fixed_point_lane(const typename T::FloatVec &z_vec) const {
+  const auto value_vec{
+      T::multiply_floats(z_vec, T::set_float(fixed_point_scale))};
+
+  return T::convert_to_ints(
+      T::min_floats(T::max_floats(value_vec, T::set_zero_float()),
+                    T::set_float(fixed_point_scale - 1.0f)));
+}
+
+template <typename T>
+typename T::FloatVec ZBuffer::decode_fixed_point_lane(
+    const typename T::IntVec &value_vec) const {
+
+  return T::multiply_floats(T::convert_to_floats(value_vec),
+                            T::set_float(1.0f / fixed_point_scale));
+}
+
+template <typename T>
+typename T::IntVec ZBuffer::load_fixed_point_lane(uint i) const {
+  if (format == DepthFormat::UNORM16)
+    return T::load_uint16s(&uint16_data[i]);
+
+  return T::load_ints_unaligned(reinterpret_cast<const int *>(&uint32_data[i]));
+}
+
+template <typename T>
+void ZBuffer::store_fixed_point_lane(uint i,
+                                     const typename T::IntVec &value_vec) {
+  if (format == DepthFormat::UNORM16)
+    T::store_uint16s(&uint16_data[i], value_vec);
+  else
+    T::store_ints_unaligned(reinterpret_cast<int *>(&uint32_data[i]),
+                            value_vec);
+}
+
+template <typename T> void ZBuffer::clear_lane(int i) {
+  const auto index{static_cast<uint>(i)};
+
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    T::store_floats(&float_data[index],
+                    T::set_float(std::numeric_limits<float>::max()));
+    break;
+  case DepthFormat::FLOAT32_REVERSED:
+    T::store_floats(&float_data[index], T::set_zero_float());
+    break;
+  case DepthFormat::UNORM16:
+  case DepthFormat::UNORM24:
+    store_fixed_point_lane<T>(
+        index, T::set_int(static_cast<int>(fixed_point_scale - 1.0f)));
+    break;
+  }
+}
+
+template <typename T>
+int ZBuffer::test_and_set_lane(const glm::ivec2 &pos,
+                               const typename T::FloatVec &z_vec,
+                               const typename T::FloatVec &mask_vec) {
+  const auto i{get_index(pos)};
+
+  int write_mask{};
+
+  if (is_fixed_point()) {
+    const auto stored_vec{load_fixed_point_lane<T>(i)};
+    const auto value_vec{encode_fixed_point_lane<T>(z_vec)};
+
+    const auto write_vec{
+        T::and_ints(T::compare_ints_gt(stored_vec, value_vec),
+                    T::cast_to_ints(mask_vec))};
+
+    write_mask = T::move_mask_float(T::cast_to_floats(write_vec));
+
+    if (write_mask)
+      store_fixed_point_lane<T>(
+          i, T::cast_to_ints(T::blend_floats(T::cast_to_floats(stored_vec),
+                                             T::cast_to_floats(value_vec),
+                                             T::cast_to_floats(write_vec))));
+  } else {
+    auto *dest{&float_data[i]};
+
+    const auto stored_vec{T::load_floats_unaligned(dest)};
+
+    // reversed buffers store the depth un-negated, so nearer is larger
+    const auto is_reversed{format == DepthFormat::FLOAT32_REVERSED};
+    const auto value_vec{is_reversed ? negate_floats<T>(z_vec) : z_vec};
+
+    const auto write_vec{T::and_floats(
+        is_reversed ? T::compare_floats_lt(stored_vec, value_vec)
+                    : T::compare_floats_lt(value_vec, stored_vec),
+        mask_vec)};
+
+    write_mask = T::move_mask_float(write_vec);
+
+    if (write_mask)
+      T::store_floats_unaligned(
+          dest, T::blend_floats(stored_vec, value_vec, write_vec));
+  }
+
+  if (write_mask)
+    mark_blocks_dirty(pos, T::LANE_WIDTH);
+
+  return write_mask;
+}
+
+template <typename T>
+typename T::FloatVec ZBuffer::get_lane(const glm::ivec2 &pos) const {
+  const auto i{get_index(pos)};
+
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    return T::load_floats_unaligned(&float_data[i]);
+  case DepthFormat::FLOAT32_REVERSED:
+    return negate_floats<T>(T::load_floats_unaligned(&float_data[i]));
+  case DepthFormat::UNORM16:
+  case DepthFormat::UNORM24:
+    return decode_fixed_point_lane<T>(load_fixed_point_lane<T>(i));
+  }
+
+  return T::set_zero_float();
+}
+
+template <typename T>
+void ZBuffer::set_lane(const glm::ivec2 &pos, const typename T::FloatVec &z_vec,
+                       const typename T::FloatVec &mask_vec) {
+  const auto i{get_index(pos)};
+
+  if (is_fixed_point()) {
+    const auto value_vec{encode_fixed_point_lane<T>(z_vec)};
+
+#ifdef USING_SIMD_AVX2
+    if constexpr (std::is_same<T, AVX2>::value)
+      if (format == DepthFormat::UNORM24) {
+        AVX2::mask_store_ints(reinterpret_cast<int *>(&uint32_data[i]),
+                              AVX2::cast_to_ints(mask_vec), value_vec);
+
+        mark_blocks_dirty(pos, T::LANE_WIDTH);
+
+        return;
+      }
+#endif
+
+    // there is no 16 bit masked store, so lanes are blended and written
+    // back whole, as the SSE2 path does for every format
+    store_fixed_point_lane<T>(
+        i, T::cast_to_ints(
+               T::blend_floats(T::cast_to_floats(load_fixed_point_lane<T>(i)),
+                               T::cast_to_floats(value_vec), mask_vec)));
+  } else {
+    auto *dest{&float_data[i]};
+
+    const auto value_vec{format == DepthFormat::FLOAT32_REVERSED
+                             ? negate_floats<T>(z_vec)
+                             : z_vec};
+
+#ifdef USING_SIMD_AVX2
+    if constexpr (std::is_same<T, AVX2>::value)
+      AVX2::mask_store_floats(dest, AVX2::cast_to_ints(mask_vec), value_vec);
+    else
+#endif
+      T::store_floats_unaligned(
+          dest,
+          T::blend_floats(T::load_floats_unaligned(dest), value_vec, mask_vec));
+  }
+
+  mark_blocks_dirty(pos, T::LANE_WIDTH);
+}
+
+template <typename T>
+typename T::FloatVec
+ZBuffer::quantise_lane(const typename T::FloatVec &z_vec) const {
+  if (!is_fixed_point())
+    return z_vec;
+
+  return decode_fixed_point_lane<T>(encode_fixed_point_lane<T>(z_vec));
+}
+
+END_KERNELS
+#endif
+
 } // namespace Archa
@@ -1,5 +1,13 @@
 #include "binner.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <utility>
+
 namespace Archa {
 
 static const std::array<Colour, 32> BIN_COLOURS = {
@@ -15,74 +23,360 @@ static const std::array<Colour, 32> BIN_COLOURS = {
     Colour(224, 224, 224), Colour(232, 232, 232), Colour(240, 240, 240),
     Colour(248, 248, 248), Colour(255, 255, 255)};
 
-void Binner::split_bins(const glm::ivec2 &size, int count) {
+const char *to_string(BinLayout layout) {
+  switch (layout) {
+  case BinLayout::GRID:
+    return "GRID";
+  case BinLayout::ADAPTIVE:
+    return "ADAPTIVE";
+  }
+
+  return "unknown";
+}
+
+std::optional<BinLayout> parse_bin_layout(std::string_view name) {
+  for (const auto layout : {BinLayout::GRID, BinLayout::ADAPTIVE})
+    if (std::ranges::equal(name, std::string_view{to_string(layout)},
+                           [](char a, char b) {
+                             return std::tolower(a) == std::tolower(b);
+                           }))
+      return layout;
+
+  return std::nullopt;
+}
+
+// bits of the quantised depth key, sorted one radix digit at a time
+static constexpr uint DEPTH_KEY_BITS{16};
+static constexpr uint RADIX_BITS{8};
+static constexpr uint RADIX_SIZE{1 << RADIX_BITS};
+
+// maps a float to an unsigned key with the same ordering, keeping only the
+// most significant bits
+static uint32 quantise_depth(float z) {
+  auto bits{std::bit_cast<uint32>(z)};
+
+  bits ^= (bits & 0x80000000) ? 0xffffffff : 0x80000000;
+
+  return bits >> (32 - DEPTH_KEY_BITS);
+}
+
+// adaptive layouts are only repartitioned once their most expensive bin
+// runs this far over the mean, and only for a partition that cuts its
+// imbalance by REPARTITION_MIN_GAIN, so frame to frame noise does not
+// reshuffle the bins
+static constexpr float REPARTITION_IMBALANCE{1.25f};
+static constexpr float REPARTITION_MIN_GAIN{0.1f};
+
+// weight of the latest frame in each cell's smoothed time
+static constexpr float TIME_SMOOTHING{0.25f};
+
+// a floor under every cell's cost, so cells that were never measured split
+// by area
+static constexpr float MIN_CELL_COST{1.0e-3f};
+
+void Binner::split_bins(const glm::ivec2 &size, int cell_size) {
+  this->size = size;
+  this->cell_size = cell_size;
+  grid_size = (size + cell_size - 1) / cell_size;
+
+  const auto cell_count{static_cast<uint>(grid_size.x * grid_size.y)};
+
+  cell_bins.resize(cell_count);
+  cell_times.assign(cell_count, 0.0f);
+
+  set_grid_bins();
+}
+
+void Binner::set_grid_bins() {
+  partition_count = 0;
+
+  std::vector<CellRect> rects{};
+
+  for (int y{0}; y < grid_size.y; y++)
+    for (int x{0}; x < grid_size.x; x++)
+      rects.emplace_back(glm::ivec2{x, y}, glm::ivec2{x + 1, y + 1});
+
+  set_bins(rects);
+}
+
+void Binner::set_bins(const std::vector<CellRect> &rects) {
   bins.clear();
 
-  const auto total_bin_count{count};
-  const auto total_area{size.x * size.y};
+  for (const auto &[min, max] : rects) {
+    const auto bin_index{static_cast<uint>(bins.size())};
+
+    for (auto y{min.y}; y < max.y; y++)
+      for (auto x{min.x}; x < max.x; x++)
+        cell_bins[static_cast<uint>(y * grid_size.x + x)] = bin_index;
 
-  const auto bin_area{static_cast<float>(total_area) / total_bin_count};
-  const auto bin_length{static_cast<int>(std::sqrt(bin_area))};
+    // cells in the last row and column are cut short by the screen edge
+    const auto pos{min * cell_size};
 
-  const auto column_count{size.x / bin_length};
-  const auto column_bin_count{total_bin_count / column_count};
+    bins.push_back(Bin{});
 
-  auto remaining_bins{total_bin_count % column_count};
+    const auto bin_colour{BIN_COLOURS[bin_index % BIN_COLOURS.size()]};
 
-  const auto total_columns_height{bin_length * total_bin_count};
+    bins.back().create(pos, glm::min(size, max * cell_size) - pos,
+                       bin_colour);
+  }
 
-  auto bin_x{0};
+  for (auto &render_triangle_bin_groups : render_triangle_queues)
+    render_triangle_bin_groups.resize(bins.size());
 
-  for (int i{0}; i < column_count; i++) {
-    auto bin_count{0};
+  sorted_bin_groups.resize(bins.size());
 
-    if (remaining_bins) {
-      bin_count = column_bin_count + 1;
-      remaining_bins -= 1;
-    } else {
-      bin_count = column_bin_count;
-    }
+  bin_costs.assign(bins.size(), 0.0f);
+  bin_order.resize(bins.size());
+
+  for (uint i{0}; i < bin_order.size(); i++)
+    bin_order[i] = i;
+}
+
+void Binner::set_layout(BinLayout layout) { this->layout = layout; }
+
+float Binner::get_cell_cost(const glm::ivec2 &cell) const {
+  return cell_times[static_cast<uint>(cell.y * grid_size.x + cell.x)] +
+         MIN_CELL_COST;
+}
 
-    const auto column_height{bin_length * bin_count};
+float Binner::get_rect_cost(const CellRect &rect) const {
+  const auto &[min, max]{rect};
 
-    auto column_width{static_cast<int>(static_cast<float>(column_height) /
-                                       total_columns_height * size.x)};
+  auto cost{0.0f};
 
-    column_width -= column_width % 8;
+  for (auto y{min.y}; y < max.y; y++)
+    for (auto x{min.x}; x < max.x; x++)
+      cost += get_cell_cost({x, y});
 
-    auto bin_width{0};
+  return cost;
+}
+
+// ratio of the most expensive cost to the mean, 1 when perfectly even
+static float get_imbalance(const std::vector<float> &costs) {
+  auto total{0.0f};
+  auto max{0.0f};
 
-    if (i == column_count - 1)
-      bin_width = size.x - bin_x;
-    else
-      bin_width = static_cast<int>(column_width);
+  for (const auto cost : costs) {
+    total += cost;
+    max = std::max(max, cost);
+  }
 
-    auto bin_height{size.y / bin_count};
+  return max * static_cast<float>(costs.size()) / total;
+}
+
+void Binner::partition(const CellRect &rect, uint count,
+                       std::vector<CellRect> &rects) const {
+  const auto &[min, max]{rect};
+  const auto extent{max - min};
+
+  if (count == 1 || extent.x * extent.y == 1) {
+    rects.push_back(rect);
+    return;
+  }
 
-    for (int j{0}; j < bin_count; j++) {
-      auto bin_y{j * bin_height};
+  // cut across the longer side, which keeps bins square and their edges,
+  // where triangles are binned twice, short
+  const auto axis{extent.x >= extent.y ? 0 : 1};
 
-      if (j == bin_count - 1)
-        bin_height += size.y - (bin_y + bin_height);
+  const auto first_count{count / 2};
 
-      bins.push_back(Bin{});
+  const auto target{get_rect_cost(rect) * static_cast<float>(first_count) /
+                    static_cast<float>(count)};
 
-      const auto bin_colour{
-          BIN_COLOURS[(bins.size() - 1) % BIN_COLOURS.size()]};
+  // the cut whose running cost of the slices before it lands nearest the
+  // first half's share
+  auto cut{min[axis] + 1};
+  auto best_error{std::numeric_limits<float>::max()};
+  auto running_cost{0.0f};
 
-      bins.back().create({bin_x, bin_y}, {bin_width, bin_height}, bin_colour);
+  for (auto i{min[axis] + 1}; i < max[axis]; i++) {
+    auto slice_min{min};
+    auto slice_max{max};
+
+    slice_min[axis] = i - 1;
+    slice_max[axis] = i;
+
+    running_cost += get_rect_cost({slice_min, slice_max});
+
+    const auto error{std::abs(running_cost - target)};
+
+    if (error < best_error) {
+      best_error = error;
+      cut = i;
     }
+  }
+
+  auto first_max{max};
+  auto second_min{min};
+
+  first_max[axis] = cut;
+  second_min[axis] = cut;
 
-    bin_x += bin_width;
+  partition({min, first_max}, first_count, rects);
+  partition({second_min, max}, count - first_count, rects);
+}
+
+void Binner::update_layout(uint worker_count) {
+  if (layout == BinLayout::GRID) {
+    if (partition_count != 0)
+      set_grid_bins();
+
+    return;
   }
 
-  render_triangle_bin_groups.resize(bins.size());
+  std::vector<CellRect> rects{};
+  std::vector<float> costs{};
+
+  const auto is_partitioned{partition_count == worker_count};
+
+  auto imbalance{0.0f};
+
+  if (is_partitioned) {
+    costs.resize(bins.size());
+
+    for (uint i{0}; i < bins.size(); i++)
+      costs[i] = get_rect_cost(get_bin_rect(i));
+
+    imbalance = get_imbalance(costs);
+
+    if (imbalance < REPARTITION_IMBALANCE)
+      return;
+  }
+
+  rects.clear();
+  partition({{0, 0}, grid_size}, worker_count, rects);
+
+  if (is_partitioned) {
+    costs.resize(rects.size());
+
+    for (uint i{0}; i < rects.size(); i++)
+      costs[i] = get_rect_cost(rects[i]);
+
+    if (get_imbalance(costs) > imbalance * (1.0f - REPARTITION_MIN_GAIN))
+      return;
+  }
+
+  partition_count = worker_count;
+
+  set_bins(rects);
+}
+
+const std::vector<std::pair<uint, BoundingBox>> &
+Binner::find_bins(const BoundingBox &box) const {
+  thread_local std::vector<std::pair<uint, BoundingBox>> result{};
+
+  result.clear();
+
+  const auto first{glm::max(box.min, glm::ivec2{0}) / cell_size};
+  const auto last{glm::min((box.max - 1) / cell_size, grid_size - 1)};
+
+  const auto get_bin{[this](int x, int y) {
+    return cell_bins[static_cast<uint>(y * grid_size.x + x)];
+  }};
+
+  for (auto y{first.y}; y <= last.y; y++) {
+    for (auto x{first.x}; x <= last.x; x++) {
+      const auto bin_index{get_bin(x, y)};
+
+      // bins are rectangles, so each is met first at its top left cell
+      // within the box
+      if ((x > first.x && get_bin(x - 1, y) == bin_index) ||
+          (y > first.y && get_bin(x, y - 1) == bin_index))
+        continue;
+
+      const auto &bin_min{bins[bin_index].get_pos()};
+      const auto &bin_max{bin_min + bins[bin_index].get_size()};
+
+      result.emplace_back(bin_index, BoundingBox{glm::max(box.min, bin_min),
+                                                 glm::min(box.max, bin_max)});
+    }
+  }
+
+  return result;
+}
+
+void Binner::resize_queues(uint count) {
+  render_triangle_queues.resize(count);
+
+  for (auto &render_triangle_bin_groups : render_triangle_queues)
+    render_triangle_bin_groups.resize(bins.size());
 }
 
 const std::vector<Bin> &Binner::get_bins() const { return bins; }
 
-std::vector<RenderTriangle> &Binner::get_render_bin_group(uint index) {
-  return render_triangle_bin_groups[index];
+Binner::CellRect Binner::get_bin_rect(uint bin_index) const {
+  const auto &bin{bins[bin_index]};
+
+  return {bin.get_pos() / cell_size,
+          (bin.get_pos() + bin.get_size() + cell_size - 1) / cell_size};
+}
+
+void Binner::record_cell_time(const glm::ivec2 &pos, float time) {
+  auto &cell_time{cell_times[static_cast<uint>(
+      pos.y / cell_size * grid_size.x + pos.x / cell_size)]};
+
+  cell_time += (time - cell_time) * TIME_SMOOTHING;
+}
+
+void Binner::set_bin_cost(uint bin_index, float cost) {
+  bin_costs[bin_index] = cost;
+}
+
+void Binner::order_bins_by_cost() {
+  std::stable_sort(
+      std::begin(bin_order), std::end(bin_order),
+      [this](uint a, uint b) { return bin_costs[a] > bin_costs[b]; });
+}
+
+const std::vector<uint> &Binner::get_bin_order() const { return bin_order; }
+
+std::vector<RenderTriangle> &Binner::get_render_bin_group(uint queue_index,
+                                                          uint bin_index) {
+  return render_triangle_queues[queue_index][bin_index];
+}
+
+void Binner::sort_bin(uint bin_index) {
+  thread_local std::vector<std::pair<uint32, const RenderTriangle *>> keys{};
+  thread_local std::vector<std::pair<uint32, const RenderTriangle *>>
+      scratch{};
+
+  keys.clear();
+
+  for (const auto &render_triangle_bin_groups : render_triangle_queues)
+    for (const auto &rt : render_triangle_bin_groups[bin_index])
+      keys.emplace_back(quantise_depth(rt.min_z), &rt);
+
+  scratch.resize(keys.size());
+
+  // least significant digit first; each pass is stable, so triangles at
+  // the same quantised depth keep their submission order
+  for (uint shift{0}; shift < DEPTH_KEY_BITS; shift += RADIX_BITS) {
+    std::array<uint, RADIX_SIZE> offsets{};
+
+    for (const auto &key : keys)
+      offsets[(key.first >> shift) & (RADIX_SIZE - 1)]++;
+
+    uint total{0};
+
+    for (auto &offset : offsets)
+      total += std::exchange(offset, total);
+
+    for (const auto &key : keys)
+      scratch[offsets[(key.first >> shift) & (RADIX_SIZE - 1)]++] = key;
+
+    keys.swap(scratch);
+  }
+
+  auto &sorted{sorted_bin_groups[bin_index]};
+  sorted.clear();
+
+  for (const auto &key : keys)
+    sorted.push_back(key.second);
+}
+
+const std::vector<const RenderTriangle *> &
+Binner::get_sorted_bin_group(uint bin_index) const {
+  return sorted_bin_groups[bin_index];
 }
 
 } // namespace Archa
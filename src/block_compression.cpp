@@ -0,0 +1,313 @@
+#include "block_compression.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#include "simd_level.hpp"
+
+namespace Archa {
+
+static constexpr uint32 OPAQUE_ALPHA{0xFF000000};
+
+static uint get_channel(uint32 texel, uint c) {
+  return (texel >> (c * 8)) & 0xFF;
+}
+
+static uint32 expand_rgb565(uint16 colour) {
+  const auto r{static_cast<uint32>((colour >> 11) & 31)};
+  const auto g{static_cast<uint32>((colour >> 5) & 63)};
+  const auto b{static_cast<uint32>(colour & 31)};
+
+  return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) |
+         (((b << 3) | (b >> 2)) << 16) | OPAQUE_ALPHA;
+}
+
+static uint16 pack_rgb565(uint32 texel) {
+  const auto r{(get_channel(texel, 0) * 31 + 127) / 255};
+  const auto g{(get_channel(texel, 1) * 63 + 127) / 255};
+  const auto b{(get_channel(texel, 2) * 31 + 127) / 255};
+
+  return static_cast<uint16>((r << 11) | (g << 5) | b);
+}
+
+// weighted average of two opaque colours
+static uint32 mix_colours(uint32 a, uint32 b, uint weight_a, uint weight_b) {
+  uint32 texel{OPAQUE_ALPHA};
+
+  for (uint c{0}; c < 3; c++)
+    texel |= ((get_channel(a, c) * weight_a + get_channel(b, c) * weight_b) /
+              (weight_a + weight_b))
+             << (c * 8);
+
+  return texel;
+}
+
+// four colour blocks interpolate two colours between the endpoints, while
+// three colour blocks, chosen in BC1 by c0 <= c1, interpolate one and leave
+// index 3 transparent
+static std::array<uint32, 4> get_colour_palette(uint16 c0, uint16 c1,
+                                                bool is_four_colour) {
+  const auto colour0{expand_rgb565(c0)};
+  const auto colour1{expand_rgb565(c1)};
+
+  if (is_four_colour)
+    return {colour0, colour1, mix_colours(colour0, colour1, 2, 1),
+            mix_colours(colour0, colour1, 1, 2)};
+
+  return {colour0, colour1, mix_colours(colour0, colour1, 1, 1), 0};
+}
+
+// alphas in the top byte, ready to merge with the colours; a0 > a1 selects
+// six interpolated values, otherwise four plus fully transparent and opaque
+static std::array<uint32, 8> get_alpha_palette(uint a0, uint a1) {
+  std::array<uint, 8> alphas{a0, a1};
+
+  if (a0 > a1) {
+    for (uint i{1}; i < 7; i++)
+      alphas[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+  } else {
+    for (uint i{1}; i < 5; i++)
+      alphas[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+
+    alphas[6] = 0;
+    alphas[7] = 255;
+  }
+
+  std::array<uint32, 8> palette{};
+
+  for (uint i{0}; i < palette.size(); i++)
+    palette[i] = alphas[i] << 24;
+
+  return palette;
+}
+
+static uint get_colour_distance(uint32 a, uint32 b) {
+  uint distance{};
+
+  for (uint c{0}; c < 3; c++) {
+    const auto delta{static_cast<int>(get_channel(a, c)) -
+                     static_cast<int>(get_channel(b, c))};
+
+    distance += static_cast<uint>(delta * delta);
+  }
+
+  return distance;
+}
+
+template <typename T, std::size_t N>
+static uint find_nearest(const std::array<uint32, N> &palette, uint count,
+                         uint32 texel, const T &get_distance) {
+  uint nearest{};
+  auto nearest_distance{std::numeric_limits<uint>::max()};
+
+  for (uint i{0}; i < count; i++) {
+    const auto distance{get_distance(palette[i], texel)};
+
+    if (distance < nearest_distance) {
+      nearest = i;
+      nearest_distance = distance;
+    }
+  }
+
+  return nearest;
+}
+
+static void compress_colour_block(const BlockTexels &texels, bool is_bc1,
+                                  uint8 *block) {
+  // BC1 keeps 1-bit alpha through the three colour mode's transparent index
+  const auto is_transparent{[is_bc1](uint32 texel) {
+    return is_bc1 && get_channel(texel, 3) < 128;
+  }};
+
+  const auto has_transparency{
+      std::ranges::any_of(texels, is_transparent)};
+
+  std::array<uint, 3> min_channels{255, 255, 255};
+  std::array<uint, 3> max_channels{};
+
+  for (const auto texel : texels) {
+    if (is_transparent(texel))
+      continue;
+
+    for (uint c{0}; c < 3; c++) {
+      min_channels[c] = std::min(min_channels[c], get_channel(texel, c));
+      max_channels[c] = std::max(max_channels[c], get_channel(texel, c));
+    }
+  }
+
+  // fully transparent tiles leave min above max; either endpoint will do
+  for (uint c{0}; c < 3; c++)
+    min_channels[c] = std::min(min_channels[c], max_channels[c]);
+
+  uint32 min_colour{};
+  uint32 max_colour{};
+
+  for (uint c{0}; c < 3; c++) {
+    min_colour |= min_channels[c] << (c * 8);
+    max_colour |= max_channels[c] << (c * 8);
+  }
+
+  auto c0{pack_rgb565(max_colour)};
+  auto c1{pack_rgb565(min_colour)};
+
+  if (has_transparency)
+    std::swap(c0, c1);
+
+  const auto is_four_colour{!is_bc1 || c0 > c1};
+  const auto palette{get_colour_palette(c0, c1, is_four_colour)};
+
+  uint32 indices{};
+
+  for (uint i{0}; i < texels.size(); i++) {
+    const auto index{
+        is_transparent(texels[i])
+            ? 3
+            : find_nearest(palette, is_four_colour ? 4 : 3, texels[i],
+                           get_colour_distance)};
+
+    indices |= index << (i * 2);
+  }
+
+  block[0] = static_cast<uint8>(c0);
+  block[1] = static_cast<uint8>(c0 >> 8);
+  block[2] = static_cast<uint8>(c1);
+  block[3] = static_cast<uint8>(c1 >> 8);
+
+  for (uint i{0}; i < 4; i++)
+    block[4 + i] = static_cast<uint8>(indices >> (i * 8));
+}
+
+static void compress_alpha_block(const BlockTexels &texels, uint8 *block) {
+  uint a0{};
+  uint a1{255};
+
+  for (const auto texel : texels) {
+    a0 = std::max(a0, get_channel(texel, 3));
+    a1 = std::min(a1, get_channel(texel, 3));
+  }
+
+  // equal endpoints fall into the four value mode, where index 0 is still a0
+  const auto palette{get_alpha_palette(a0, a1)};
+
+  uint64 indices{};
+
+  for (uint i{0}; i < texels.size(); i++) {
+    const auto index{find_nearest(
+        palette, static_cast<uint>(palette.size()), texels[i],
+        [](uint32 a, uint32 b) {
+          return static_cast<uint>(std::abs(static_cast<int>(a >> 24) -
+                                            static_cast<int>(b >> 24)));
+        })};
+
+    indices |= static_cast<uint64>(index) << (i * 3);
+  }
+
+  block[0] = static_cast<uint8>(a0);
+  block[1] = static_cast<uint8>(a1);
+
+  for (uint i{0}; i < 6; i++)
+    block[2 + i] = static_cast<uint8>(indices >> (i * 8));
+}
+
+void compress_block(TextureFormat format, const BlockTexels &texels,
+                    uint8 *block) {
+  if (format == TextureFormat::BC3) {
+    compress_alpha_block(texels, block);
+    compress_colour_block(texels, false, block + 8);
+  } else {
+    compress_colour_block(texels, true, block);
+  }
+}
+
+template <std::size_t N>
+static void look_up_palette(const std::array<uint32, N> &palette,
+                            const BlockIndices &indices, uint32 *texels) {
+  switch (get_simd_level()) {
+#ifdef USING_SIMD_AVX2
+  case SimdLevel::AVX2:
+    look_up_palette_avx2(palette.data(), N, indices, texels);
+    return;
+#endif
+#ifdef USING_SIMD_SSE2
+  case SimdLevel::SSE2:
+    look_up_palette_sse2(palette.data(), N, indices, texels);
+    return;
+#endif
+  default:
+    for (uint i{0}; i < indices.size(); i++)
+      texels[i] = palette[static_cast<uint>(indices[i])];
+  }
+}
+
+// texels must be aligned for the SIMD stores
+void decode_block(TextureFormat format, const uint8 *block, uint32 *texels) {
+  const auto *colour_block{format == TextureFormat::BC3 ? block + 8 : block};
+
+  const auto c0{static_cast<uint16>(colour_block[0] | colour_block[1] << 8)};
+  const auto c1{static_cast<uint16>(colour_block[2] | colour_block[3] << 8)};
+
+  uint32 colour_indices{};
+
+  for (uint i{0}; i < 4; i++)
+    colour_indices |= static_cast<uint32>(colour_block[4 + i]) << (i * 8);
+
+  alignas(SIMD_ALIGN_WIDTH) BlockIndices indices{};
+
+  for (uint i{0}; i < indices.size(); i++)
+    indices[i] = static_cast<int>((colour_indices >> (i * 2)) & 3);
+
+  look_up_palette(
+      get_colour_palette(c0, c1, format == TextureFormat::BC3 || c0 > c1),
+      indices, texels);
+
+  if (format != TextureFormat::BC3)
+    return;
+
+  uint64 alpha_indices{};
+
+  for (uint i{0}; i < 6; i++)
+    alpha_indices |= static_cast<uint64>(block[2 + i]) << (i * 8);
+
+  for (uint i{0}; i < indices.size(); i++)
+    indices[i] = static_cast<int>((alpha_indices >> (i * 3)) & 7);
+
+  alignas(SIMD_ALIGN_WIDTH) BlockTexels alphas{};
+  look_up_palette(get_alpha_palette(block[0], block[1]), indices,
+                  alphas.data());
+
+  for (uint i{0}; i < alphas.size(); i++)
+    texels[i] = (texels[i] & ~OPAQUE_ALPHA) | alphas[i];
+}
+
+// tiles decoded most recently by this thread, direct mapped on the level and
+// tile so that the levels of several textures can share it
+struct DecodedTileCache {
+  static constexpr uint SIZE{64};
+
+  std::array<uint64, SIZE> tags{};
+  alignas(SIMD_ALIGN_WIDTH) std::array<BlockTexels, SIZE> tiles{};
+};
+
+static thread_local DecodedTileCache decoded_tile_cache{};
+
+const uint32 *get_decoded_tile(const MipLevel &level, uint tile) {
+  auto &cache{decoded_tile_cache};
+
+  // level ids start at 1, so no tag matches an empty slot
+  const auto tag{static_cast<uint64>(level.id) << 32 | tile};
+  const auto slot{(tile + level.id * 0x9E3779B1u) % DecodedTileCache::SIZE};
+
+  auto *texels{cache.tiles[slot].data()};
+
+  if (cache.tags[slot] != tag) {
+    const auto block_size{get_block_size(level.format)};
+
+    decode_block(level.format, &level.blocks[tile * block_size], texels);
+    cache.tags[slot] = tag;
+  }
+
+  return texels;
+}
+
+} // namespace Archa
@@ -0,0 +1,29 @@
+#include "block_compression.hpp"
+
+#include "intrinsics.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+// one permute looks up a whole lane of up to eight entries
+void look_up_palette_avx2(const uint32 *palette, uint palette_size,
+                          const BlockIndices &indices, uint32 *texels) {
+  alignas(SIMD_ALIGN_WIDTH) AVX2::Array<int> entries{};
+
+  for (uint i{0}; i < entries.size(); i++)
+    entries[i] = static_cast<int>(palette[i % palette_size]);
+
+  const auto palette_vec{AVX2::load_ints(entries.data())};
+
+  for (uint i{0}; i < indices.size(); i += AVX2::LANE_WIDTH)
+    AVX2::store_ints(reinterpret_cast<int *>(&texels[i]),
+                     AVX2::permute_ints(palette_vec,
+                                        AVX2::load_ints(&indices[i])));
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
@@ -0,0 +1,31 @@
+#include "block_compression.hpp"
+
+#include "intrinsics.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+
+// blends in each entry over the lanes whose index has reached it
+void look_up_palette_sse2(const uint32 *palette, uint palette_size,
+                          const BlockIndices &indices, uint32 *texels) {
+  for (uint i{0}; i < indices.size(); i += SSE2::LANE_WIDTH) {
+    const auto index_vec{SSE2::load_ints(&indices[i])};
+
+    auto texel_vec{SSE2::set_int(static_cast<int>(palette[0]))};
+
+    for (uint p{1}; p < palette_size; p++)
+      texel_vec = SSE2::blend_ints(
+          texel_vec, SSE2::set_int(static_cast<int>(palette[p])),
+          SSE2::compare_ints_gt(index_vec,
+                                SSE2::set_int(static_cast<int>(p - 1))));
+
+    SSE2::store_ints(reinterpret_cast<int *>(&texels[i]), texel_vec);
+  }
+}
+
+END_SSE2_TARGET
+#endif
+
+} // namespace Archa
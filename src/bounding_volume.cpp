@@ -0,0 +1,50 @@
+#include "bounding_volume.hpp"
+
+#include "types.hpp"
+
+namespace Archa {
+
+BoundingVolume
+BoundingVolume::from_points(const std::vector<Vertex> &vertices) {
+  BoundingVolume volume{};
+
+  if (vertices.empty())
+    return volume;
+
+  volume.min = vertices[0];
+  volume.max = vertices[0];
+
+  for (const auto &vertex : vertices) {
+    volume.min = glm::min(volume.min, glm::vec3{vertex});
+    volume.max = glm::max(volume.max, glm::vec3{vertex});
+  }
+
+  volume.centre = (volume.min + volume.max) * 0.5f;
+
+  for (const auto &vertex : vertices)
+    volume.radius =
+        glm::max(volume.radius, glm::length(glm::vec3{vertex} - volume.centre));
+
+  return volume;
+}
+
+bool BoundingVolume::is_outside(const Frustum &frustum) const {
+  for (const auto &plane : frustum.planes) {
+    const glm::vec3 normal{plane};
+
+    if (glm::dot(normal, centre) + plane.w < -radius)
+      return true;
+
+    // the box corner furthest along the plane normal
+    const glm::vec3 corner{normal.x >= 0.0f ? max.x : min.x,
+                           normal.y >= 0.0f ? max.y : min.y,
+                           normal.z >= 0.0f ? max.z : min.z};
+
+    if (glm::dot(normal, corner) + plane.w < 0.0f)
+      return true;
+  }
+
+  return false;
+}
+
+} // namespace Archa
@@ -0,0 +1,82 @@
+#include "clipper.hpp"
+
+namespace Archa {
+
+static constexpr std::array<ClipPlane, 6> CLIP_PLANES{
+    CLIP_NEAR, CLIP_LEFT, CLIP_RIGHT, CLIP_BOTTOM, CLIP_TOP, CLIP_FAR};
+
+static float plane_distance(const glm::vec4 &clip, ClipPlane plane,
+                            const glm::vec2 &guard_band) {
+  switch (plane) {
+  case CLIP_NEAR:
+    return clip.z + clip.w;
+  case CLIP_LEFT:
+    return clip.x + guard_band.x * clip.w;
+  case CLIP_RIGHT:
+    return guard_band.x * clip.w - clip.x;
+  case CLIP_BOTTOM:
+    return clip.y + guard_band.y * clip.w;
+  case CLIP_TOP:
+    return guard_band.y * clip.w - clip.y;
+  case CLIP_FAR:
+    return clip.w - clip.z;
+  }
+
+  return 0.0f;
+}
+
+static ClipVertex interpolate(const ClipVertex &a, const ClipVertex &b,
+                              float t) {
+  return {a.clip + (b.clip - a.clip) * t,
+          a.colour + (b.colour - a.colour) * t, a.uv + (b.uv - a.uv) * t,
+          a.normal + (b.normal - a.normal) * t};
+}
+
+void Clipper::set_guard_band(const glm::vec2 &guard_band) {
+  this->guard_band = guard_band;
+}
+
+uint8 Clipper::compute_outcode(const glm::vec4 &clip) const {
+  uint8 outcode{0};
+
+  for (const auto plane : CLIP_PLANES)
+    if (plane_distance(clip, plane, guard_band) < 0.0f)
+      outcode |= plane;
+
+  return outcode;
+}
+
+void Clipper::clip(ClipPolygon &polygon, uint8 planes) const {
+  ClipPolygon result{};
+
+  for (const auto plane : CLIP_PLANES) {
+    if (!(planes & plane))
+      continue;
+
+    result.count = 0;
+
+    for (uint i{0}; i < polygon.count; i++) {
+      const auto &a{polygon.vertices[i]};
+      const auto &b{polygon.vertices[(i + 1) % polygon.count]};
+
+      const auto a_distance{plane_distance(a.clip, plane, guard_band)};
+      const auto b_distance{plane_distance(b.clip, plane, guard_band)};
+
+      if (a_distance >= 0.0f)
+        result.vertices[result.count++] = a;
+
+      if ((a_distance >= 0.0f) != (b_distance >= 0.0f))
+        result.vertices[result.count++] =
+            interpolate(a, b, a_distance / (a_distance - b_distance));
+    }
+
+    polygon = result;
+
+    if (polygon.count < 3) {
+      polygon.count = 0;
+      return;
+    }
+  }
+}
+
+} // namespace Archa
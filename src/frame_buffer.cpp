@@ -1,6 +1,9 @@
 #include "frame_buffer.hpp"
 
+#include <cstdint>
+
 #include "constants.hpp"
+#include "simd_level.hpp"
 
 namespace Archa {
 
@@ -18,33 +21,75 @@ void FrameBuffer::set_pixel(const glm::ivec2 &pos, const Colour &colour) {
   memcpy(&pixels[index], &colour, sizeof(Colour));
 }
 
-#ifdef USING_SIMD_SSE2
-void FrameBuffer::set_pixels(const glm::ivec2 &pos,
-                             const SSE2::Array<Colour> &colours) {
+void FrameBuffer::fill(const glm::ivec2 &min, const glm::ivec2 &max,
+                       const Colour &colour) {
+  [[maybe_unused]] const auto simd_level{get_simd_level()};
 
-  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
-                   RGBA_CHANNEL_COUNT};
+  for (int y{min.y}; y < max.y; y++) {
+    auto x{min.x};
 
-  const auto colours_vec{
-      SSE2::load_ints(reinterpret_cast<const int *>(colours.data()))};
+#ifdef USING_SIMD_AVX2
+    if (simd_level >= SimdLevel::AVX2)
+      x = fill_lanes_avx2({x, y}, max.x, colour);
+#endif
 
-  SSE2::store_ints(reinterpret_cast<int *>(&pixels[index]), colours_vec);
+#ifdef USING_SIMD_SSE2
+    if (simd_level >= SimdLevel::SSE2)
+      x = fill_lanes_sse2({x, y}, max.x, colour);
+#endif
+
+    for (; x < max.x; x++)
+      set_pixel({x, y}, colour);
+  }
 }
+
+void FrameBuffer::resolve(const FrameBuffer &tile, const glm::ivec2 &pos,
+                          const glm::ivec2 &size) {
+  [[maybe_unused]] const auto simd_level{get_simd_level()};
+
+  // streaming stores need their destination aligned to the lane
+  [[maybe_unused]] const auto alignment{static_cast<uintptr_t>(
+      simd_level >= SimdLevel::AVX2 ? ALIGN_AVX2_WIDTH : ALIGN_SSE2_WIDTH)};
+
+  for (int y{0}; y < size.y; y++) {
+    const auto src_index{static_cast<uint>(y * tile.size.x) *
+                         RGBA_CHANNEL_COUNT};
+
+    const auto dest_index{static_cast<uint>((pos.y + y) * this->size.x +
+                                            pos.x) *
+                          RGBA_CHANNEL_COUNT};
+
+    const auto *src{reinterpret_cast<const int *>(&tile.pixels[src_index])};
+    auto *dest{reinterpret_cast<int *>(&pixels[dest_index])};
+
+    auto x{0};
+
+#ifdef USING_SIMD_SSE2
+    for (; simd_level >= SimdLevel::SSE2 && x < size.x &&
+           reinterpret_cast<uintptr_t>(dest + x) % alignment;
+         x++)
+      dest[x] = src[x];
 #endif
 
 #ifdef USING_SIMD_AVX2
-void FrameBuffer::set_pixels(const glm::ivec2 &pos,
-                             const AVX2::Array<Colour> &colours) {
+    if (simd_level >= SimdLevel::AVX2)
+      x = stream_lanes_avx2(src, dest, x, size.x);
+#endif
 
-  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
-                   RGBA_CHANNEL_COUNT};
+#ifdef USING_SIMD_SSE2
+    if (simd_level >= SimdLevel::SSE2)
+      x = stream_lanes_sse2(src, dest, x, size.x);
+#endif
 
-  const auto colours_vec{
-      AVX2::load_ints(reinterpret_cast<const int *>(colours.data()))};
+    for (; x < size.x; x++)
+      dest[x] = src[x];
+  }
 
-  AVX2::store_ints(reinterpret_cast<int *>(&pixels[index]), colours_vec);
-}
+#ifdef USING_SIMD_SSE2
+  if (simd_level >= SimdLevel::SSE2)
+    SSE2::fence_stores();
 #endif
+}
 
 const uint8 *FrameBuffer::get_pixels() const { return pixels.data(); }
 
@@ -0,0 +1,57 @@
+#include "frame_buffer.hpp"
+
+#include "constants.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+int FrameBuffer::fill_lanes_avx2(const glm::ivec2 &pos, int max_x,
+                                 const Colour &colour) {
+  ALIGN_AVX2 const AVX2::Array<Colour> colours{
+      colour, colour, colour, colour, colour, colour, colour, colour};
+
+  auto x{pos.x};
+
+  for (; x < max_x - (AVX2::LANE_WIDTH - 1); x += AVX2::LANE_WIDTH)
+    set_pixels({x, pos.y}, colours);
+
+  return x;
+}
+
+int FrameBuffer::stream_lanes_avx2(const int *src, int *dest, int x,
+                                   int max_x) {
+  for (; x < max_x - (AVX2::LANE_WIDTH - 1); x += AVX2::LANE_WIDTH)
+    AVX2::stream_ints(dest + x, AVX2::load_ints_unaligned(src + x));
+
+  return x;
+}
+
+void FrameBuffer::set_pixels(const glm::ivec2 &pos,
+                             const AVX2::Array<Colour> &colours) {
+
+  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
+                   RGBA_CHANNEL_COUNT};
+
+  const auto colours_vec{
+      AVX2::load_ints(reinterpret_cast<const int *>(colours.data()))};
+
+  AVX2::store_ints(reinterpret_cast<int *>(&pixels[index]), colours_vec);
+}
+
+void FrameBuffer::set_pixels_masked(const glm::ivec2 &pos,
+                                    const __m256i &colours_vec,
+                                    const __m256i &mask_vec) {
+
+  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
+                   RGBA_CHANNEL_COUNT};
+
+  AVX2::mask_store_ints(reinterpret_cast<int *>(&pixels[index]), mask_vec,
+                        colours_vec);
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
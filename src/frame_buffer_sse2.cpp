@@ -0,0 +1,59 @@
+#include "frame_buffer.hpp"
+
+#include "constants.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+
+int FrameBuffer::fill_lanes_sse2(const glm::ivec2 &pos, int max_x,
+                                 const Colour &colour) {
+  ALIGN_SSE2 const SSE2::Array<Colour> colours{colour, colour, colour, colour};
+
+  auto x{pos.x};
+
+  for (; x < max_x - (SSE2::LANE_WIDTH - 1); x += SSE2::LANE_WIDTH)
+    set_pixels({x, pos.y}, colours);
+
+  return x;
+}
+
+int FrameBuffer::stream_lanes_sse2(const int *src, int *dest, int x,
+                                   int max_x) {
+  for (; x < max_x - (SSE2::LANE_WIDTH - 1); x += SSE2::LANE_WIDTH)
+    SSE2::stream_ints(dest + x, SSE2::load_ints_unaligned(src + x));
+
+  return x;
+}
+
+void FrameBuffer::set_pixels(const glm::ivec2 &pos,
+                             const SSE2::Array<Colour> &colours) {
+
+  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
+                   RGBA_CHANNEL_COUNT};
+
+  const auto colours_vec{
+      SSE2::load_ints(reinterpret_cast<const int *>(colours.data()))};
+
+  SSE2::store_ints(reinterpret_cast<int *>(&pixels[index]), colours_vec);
+}
+
+void FrameBuffer::set_pixels_masked(const glm::ivec2 &pos,
+                                    const __m128i &colours_vec,
+                                    const __m128i &mask_vec) {
+
+  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
+                   RGBA_CHANNEL_COUNT};
+
+  auto *dest{reinterpret_cast<int *>(&pixels[index])};
+
+  SSE2::store_ints_unaligned(
+      dest, SSE2::blend_ints(SSE2::load_ints_unaligned(dest), colours_vec,
+                             mask_vec));
+}
+
+END_SSE2_TARGET
+#endif
+
+} // namespace Archa
@@ -0,0 +1,25 @@
+#include "frustum.hpp"
+
+#include "types.hpp"
+
+namespace Archa {
+
+Frustum Frustum::from_matrix(const glm::mat4 &matrix) {
+  std::array<glm::vec4, 4> rows{};
+
+  for (int i{0}; i < 4; i++)
+    rows[static_cast<uint>(i)] = {matrix[0][i], matrix[1][i], matrix[2][i],
+                                  matrix[3][i]};
+
+  Frustum frustum{};
+
+  frustum.planes = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                    rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]};
+
+  for (auto &plane : frustum.planes)
+    plane /= glm::length(glm::vec3{plane});
+
+  return frustum;
+}
+
+} // namespace Archa
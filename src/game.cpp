@@ -91,6 +91,8 @@ void Game::setup_scene() {
 
   model.triangles.push_back(triangle2);
 
+  model.compute_bounds();
+
   // for (int i = 0; i < 25; i++) {
   ModelInstance model_instance{model};
 
@@ -229,4 +231,6 @@ void Game::run(uint max_frame_rate) {
   ImGui::SFML::Shutdown();
 }
 
+Viewport &Game::get_viewport() { return viewport; }
+
 } // namespace Archa
@@ -1,11 +1,79 @@
 #include "image.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#include "block_compression.hpp"
 #include "constants.hpp"
 #include "error.hpp"
 #include "logger.hpp"
 
 namespace Archa {
 
+void MipLevel::resize(const glm::ivec2 &size) {
+  this->size = size;
+  tile_columns = (size.x + TILE_SIZE - 1) >> TILE_SHIFT;
+
+  const auto tile_rows{(size.y + TILE_SIZE - 1) >> TILE_SHIFT};
+
+  texels.resize(static_cast<uint>(tile_columns * tile_rows) *
+                TILE_SIZE * TILE_SIZE);
+}
+
+uint MipLevel::get_index(int x, int y) const {
+  const auto tile{(y >> TILE_SHIFT) * tile_columns + (x >> TILE_SHIFT)};
+
+  const auto texel{((y & (TILE_SIZE - 1)) << TILE_SHIFT) +
+                   (x & (TILE_SIZE - 1))};
+
+  return static_cast<uint>((tile << (TILE_SHIFT * 2)) + texel);
+}
+
+void MipLevel::compress(TextureFormat format) {
+  static std::atomic<uint32> next_id{1};
+
+  const auto block_size{get_block_size(format)};
+  const auto tile_count{static_cast<uint>(texels.size()) / BLOCK_TEXEL_COUNT};
+
+  blocks.resize(tile_count * block_size);
+
+  for (uint tile{0}; tile < tile_count; tile++) {
+    const glm::ivec2 tile_min{
+        static_cast<int>(tile % static_cast<uint>(tile_columns)) * TILE_SIZE,
+        static_cast<int>(tile / static_cast<uint>(tile_columns)) * TILE_SIZE};
+
+    // the padding of edge tiles repeats the last row and column, which keeps
+    // it out of the endpoints and BC1's transparent mode
+    BlockTexels tile_texels{};
+
+    for (int y{0}; y < TILE_SIZE; y++)
+      for (int x{0}; x < TILE_SIZE; x++)
+        tile_texels[static_cast<uint>(y * TILE_SIZE + x)] =
+            texels[get_index(std::min(tile_min.x + x, size.x - 1),
+                             std::min(tile_min.y + y, size.y - 1))];
+
+    compress_block(format, tile_texels, &blocks[tile * block_size]);
+  }
+
+  this->format = format;
+  id = next_id.fetch_add(1, std::memory_order_relaxed);
+
+  texels = {};
+}
+
+uint32 MipLevel::get_texel(int x, int y) const {
+  const auto index{get_index(x, y)};
+
+  if (format == TextureFormat::RGBA8)
+    return texels[index];
+
+  const auto *tile{get_decoded_tile(*this, index / BLOCK_TEXEL_COUNT)};
+
+  return tile[index % BLOCK_TEXEL_COUNT];
+}
+
 void Image::load(const std::filesystem::path &file_path) {
   if (!image.loadFromFile(file_path.string()))
     fatal_error("Failed to load image: " + file_path.string());
@@ -13,19 +81,93 @@ void Image::load(const std::filesystem::path &file_path) {
   size = {image.getSize().x, image.getSize().y};
   pixels = image.getPixelsPtr();
 
-  Logger().info() << "Loaded image: " << file_path
-                  << ", size: " << image.getSize().x << "x" << image.getSize().y
+  build_mip_chain();
+
+  // the mip chain holds its own copy of the pixels
+  image = {};
+  pixels = nullptr;
+
+  Logger().info() << "Loaded image: " << file_path << ", size: " << size.x
+                  << "x" << size.y << ", mip levels: " << mip_levels.size()
+                  << ", format: " << to_string(mip_levels.front().format)
                   << '\n';
 }
 
+// averages each 2x2 footprint of the level above, repeating the last row or
+// column of odd sized levels
+void Image::build_mip_chain() {
+  mip_levels.clear();
+
+  auto &base{mip_levels.emplace_back()};
+  base.resize(size);
+
+  for (int y{0}; y < size.y; y++)
+    for (int x{0}; x < size.x; x++)
+      std::memcpy(&base.texels[base.get_index(x, y)],
+                  &pixels[static_cast<uint>(y * size.x + x) *
+                          RGBA_CHANNEL_COUNT],
+                  sizeof(uint32));
+
+  while (mip_levels.back().size.x > 1 || mip_levels.back().size.y > 1) {
+    const auto &source{mip_levels.back()};
+
+    MipLevel level{};
+    level.resize(glm::max(source.size / 2, {1, 1}));
+
+    for (int y{0}; y < level.size.y; y++) {
+      for (int x{0}; x < level.size.x; x++) {
+        const std::array<int, 2> xs{std::min(x * 2, source.size.x - 1),
+                                    std::min(x * 2 + 1, source.size.x - 1)};
+
+        const std::array<int, 2> ys{std::min(y * 2, source.size.y - 1),
+                                    std::min(y * 2 + 1, source.size.y - 1)};
+
+        std::array<uint, RGBA_CHANNEL_COUNT> sums{};
+
+        for (const auto source_y : ys) {
+          for (const auto source_x : xs) {
+            const auto texel{
+                source.texels[source.get_index(source_x, source_y)]};
+
+            for (uint c{0}; c < sums.size(); c++)
+              sums[c] += (texel >> (c * 8)) & 0xFF;
+          }
+        }
+
+        uint32 texel{};
+
+        for (uint c{0}; c < sums.size(); c++)
+          texel |= ((sums[c] + 2) / 4) << (c * 8);
+
+        level.texels[level.get_index(x, y)] = texel;
+      }
+    }
+
+    mip_levels.push_back(std::move(level));
+  }
+
+  if (const auto format{get_texture_format()}; format != TextureFormat::RGBA8)
+    for (auto &level : mip_levels)
+      level.compress(format);
+}
+
 const glm::ivec2 &Image::get_size() const { return size; }
-const uint8 *Image::get_pixels() const { return pixels; }
 
-const Colour &Image::get_pixel(const glm::ivec2 &pos) const {
-  const auto index{static_cast<uint>(pos.y * size.x + pos.x) *
-                   RGBA_CHANNEL_COUNT};
+Colour Image::get_pixel(const glm::ivec2 &pos) const {
+  const auto texel{mip_levels.front().get_texel(pos.x, pos.y)};
+
+  Colour colour{};
+  std::memcpy(&colour, &texel, sizeof(texel));
+
+  return colour;
+}
+
+uint Image::get_level_count() const {
+  return static_cast<uint>(mip_levels.size());
+}
 
-  return *reinterpret_cast<const Colour *>(&pixels[index]);
+const MipLevel &Image::get_level(uint level) const {
+  return mip_levels[level];
 }
 
 } // namespace Archa
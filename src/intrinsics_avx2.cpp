@@ -0,0 +1,215 @@
+#include "intrinsics.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+__m256i AVX2::minus_one_ints{-1, -1, -1, -1};
+
+__m256i AVX2::load_ints(const int *src) {
+  return _mm256_load_si256(reinterpret_cast<const __m256i *>(src));
+}
+
+__m256i AVX2::load_ints_unaligned(const int *src) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+}
+
+__m256i AVX2::mask_gather_ints(const int *base, const __m256i &indices,
+                               const __m256i &mask) {
+  return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), base, indices,
+                                     mask, sizeof(int));
+}
+
+__m256 AVX2::load_floats(const float *src) { return _mm256_load_ps(src); }
+
+__m256 AVX2::load_floats_unaligned(const float *src) {
+  return _mm256_loadu_ps(src);
+}
+
+__m256i AVX2::load_uint16s(const uint16 *src) {
+  return _mm256_cvtepu16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+}
+
+__m256i AVX2::set_zero_int() { return _mm256_setzero_si256(); }
+__m256 AVX2::set_zero_float() { return _mm256_setzero_ps(); }
+
+__m256i AVX2::set_int(int a) { return _mm256_set1_epi32(a); }
+__m256 AVX2::set_float(float a) { return _mm256_set1_ps(a); }
+
+__m256i AVX2::set_ints(int a, int b, int c, int d, int e, int f, int g, int h) {
+  return _mm256_set_epi32(a, b, c, d, e, f, g, h);
+}
+
+__m256 AVX2::set_floats(float a, float b, float c, float d, float e, float f,
+                        float g, float h) {
+  return _mm256_set_ps(a, b, c, d, e, f, g, h);
+}
+
+__m256i AVX2::or_ints(const std::array<__m256i, 3> &vecs) {
+  return _mm256_or_si256(_mm256_or_si256(vecs[0], vecs[1]), vecs[2]);
+}
+
+__m256i AVX2::or_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_or_si256(a, b);
+}
+
+__m256i AVX2::shift_left_ints(const __m256i &vec, int count) {
+  return _mm256_slli_epi32(vec, count);
+}
+
+__m256i AVX2::shift_right_ints(const __m256i &vec, int count) {
+  return _mm256_srli_epi32(vec, count);
+}
+
+__m256i AVX2::permute_ints(const __m256i &vec, const __m256i &indices) {
+  return _mm256_permutevar8x32_epi32(vec, indices);
+}
+
+__m256i AVX2::and_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_and_si256(a, b);
+}
+
+__m256 AVX2::and_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_and_ps(a, b);
+}
+
+__m256 AVX2::divide_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_div_ps(a, b);
+}
+
+__m256i AVX2::multiply_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_mullo_epi32(a, b);
+}
+
+__m256 AVX2::multiply_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_mul_ps(a, b);
+}
+
+__m256i AVX2::add_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_add_epi32(a, b);
+}
+
+__m256 AVX2::add_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_add_ps(a, b);
+}
+
+__m256 AVX2::add_floats(const std::array<__m256, 3> &vecs) {
+  return _mm256_add_ps(_mm256_add_ps(vecs[0], vecs[1]), vecs[2]);
+}
+
+__m256i AVX2::subtract_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_sub_epi32(a, b);
+}
+
+__m256 AVX2::subtract_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_sub_ps(a, b);
+}
+
+__m256i AVX2::min_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_min_epi32(a, b);
+}
+
+__m256i AVX2::max_ints(const __m256i &a, const __m256i &b) {
+  return _mm256_max_epi32(a, b);
+}
+
+__m256 AVX2::min_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_min_ps(a, b);
+}
+
+__m256 AVX2::max_floats(const __m256 &a, const __m256 &b) {
+  return _mm256_max_ps(a, b);
+}
+
+__m256 AVX2::floor_floats(const __m256 &vec) { return _mm256_floor_ps(vec); }
+
+__m256i AVX2::horizontal_add_ints(const __m256i &vec) {
+  return _mm256_hadd_epi32(vec, vec);
+}
+
+__m256 AVX2::horizontal_add_floats(const __m256 &vec) {
+  return _mm256_hadd_ps(vec, vec);
+}
+
+__m256i AVX2::convert_to_ints(const __m256 &vec) {
+  return _mm256_cvtps_epi32(vec);
+}
+
+__m256 AVX2::convert_to_floats(const __m256i &vec) {
+  return _mm256_cvtepi32_ps(vec);
+}
+
+__m256i AVX2::compare_ints_gt(const __m256i &a, const __m256i &b) {
+  return _mm256_cmpgt_epi32(a, b);
+}
+
+__m256 AVX2::compare_floats_lt(const __m256 &a, const __m256 &b) {
+  return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+
+__m256 AVX2::compare_floats_eq(const __m256 &a, const __m256 &b) {
+  return _mm256_cmp_ps(a, b, _CMP_EQ_OQ);
+}
+
+__m256i AVX2::cast_to_ints(const __m256 &vec) {
+  return _mm256_castps_si256(vec);
+}
+
+__m256 AVX2::cast_to_floats(const __m256i &vec) {
+  return _mm256_castsi256_ps(vec);
+}
+
+__m256 AVX2::blend_floats(const __m256 &a, const __m256 &b,
+                          const __m256 &mask) {
+  return _mm256_blendv_ps(a, b, mask);
+}
+
+int AVX2::move_mask_int8(const __m256i &vec) {
+  return _mm256_movemask_epi8(vec);
+}
+
+int AVX2::move_mask_float(const __m256 &vec) {
+  return _mm256_movemask_ps(vec);
+}
+
+void AVX2::store_ints(int *dest, const __m256i &src) {
+  _mm256_store_si256(reinterpret_cast<__m256i *>(dest), src);
+}
+
+void AVX2::store_ints_unaligned(int *dest, const __m256i &src) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), src);
+}
+
+void AVX2::store_floats(float *dest, const __m256 &src) {
+  _mm256_store_ps(dest, src);
+}
+
+void AVX2::store_floats_unaligned(float *dest, const __m256 &src) {
+  _mm256_storeu_ps(dest, src);
+}
+
+void AVX2::store_uint16s(uint16 *dest, const __m256i &src) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dest),
+                   _mm_packus_epi32(_mm256_castsi256_si128(src),
+                                    _mm256_extracti128_si256(src, 1)));
+}
+
+void AVX2::stream_ints(int *dest, const __m256i &src) {
+  _mm256_stream_si256(reinterpret_cast<__m256i *>(dest), src);
+}
+
+void AVX2::mask_store_ints(int *dest, const __m256i &mask, const __m256i &src) {
+  _mm256_maskstore_epi32(dest, mask, src);
+}
+
+void AVX2::mask_store_floats(float *dest, const __m256i &mask,
+                             const __m256 &src) {
+  _mm256_maskstore_ps(dest, mask, src);
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
@@ -1,22 +1,87 @@
 #include "game.hpp"
 
 #include "config.hpp"
+
+#include <cstdlib>
+#include <string_view>
+
+#include "binner.hpp"
 #include "logger.hpp"
+#include "simd_level.hpp"
+#include "texture_format.hpp"
+#include "z_buffer.hpp"
 
 using namespace Archa;
 
+// a switch is on when its variable is set to anything but 0, and keeps its
+// default when unset
+static bool is_switch_enabled(const char *name, bool is_default = false) {
+  const auto *value{std::getenv(name)};
+
+  if (!value)
+    return is_default;
+
+  return std::string_view{value} != "0";
+}
+
 int main() {
   Logger().info() << "Starting Archa Engine" << '\n';
 
-#ifdef USING_SIMD_AVX2
-  Logger().info() << "Using AVX2 SIMD (32-byte alignment)" << '\n';
-#elif defined USING_SIMD_SSE2
-  Logger().info() << "Using SSE2 SIMD (16-byte alignment)" << '\n';
-#else
-  Logger().info() << "No SIMD" << '\n';
-#endif
+  // lets the SSE2, AVX2 and scalar kernels be compared without rebuilding
+  if (const auto *name{std::getenv("ARCHA_SIMD")}) {
+    if (const auto level{parse_simd_level(name)})
+      set_simd_level(*level);
+    else
+      Logger().warn() << "Unknown ARCHA_SIMD level " << name << '\n';
+  }
+
+  Logger().info() << "CPU supports " << to_string(get_cpu_simd_level())
+                  << ", running " << to_string(get_simd_level()) << " kernels"
+                  << '\n';
+
+  // block compressed textures trade some quality for a fraction of the
+  // memory and bandwidth
+  if (const auto *name{std::getenv("ARCHA_TEXTURE_FORMAT")}) {
+    if (const auto format{parse_texture_format(name)})
+      set_texture_format(*format);
+    else
+      Logger().warn() << "Unknown ARCHA_TEXTURE_FORMAT " << name << '\n';
+  }
 
   Game game{};
+
+  // rasterises depth and triangle ids first, then shades each pixel once
+  game.get_viewport().set_visibility_buffer_enabled(
+      is_switch_enabled("ARCHA_VISIBILITY_BUFFER"));
+
+  // rasterises depth only first, then shades where the depth matches, which
+  // pays off in scenes with heavy overdraw
+  game.get_viewport().set_depth_prepass_enabled(
+      is_switch_enabled("ARCHA_DEPTH_PREPASS"));
+
+  // takes the bins that cost most last frame first; ARCHA_COST_ORDERING=0
+  // keeps them in screen order, to compare against
+  game.get_viewport().set_cost_ordering_enabled(
+      is_switch_enabled("ARCHA_COST_ORDERING", true));
+
+  // UNORM16 halves depth bandwidth, while FLOAT32_REVERSED keeps precision
+  // out to the far plane
+  if (const auto *name{std::getenv("ARCHA_DEPTH_FORMAT")}) {
+    if (const auto format{parse_depth_format(name)})
+      game.get_viewport().set_depth_format(*format);
+    else
+      Logger().warn() << "Unknown ARCHA_DEPTH_FORMAT " << name << '\n';
+  }
+
+  // ADAPTIVE suits views that change little from frame to frame, such as a
+  // kiosk's fixed camera
+  if (const auto *name{std::getenv("ARCHA_BIN_LAYOUT")}) {
+    if (const auto layout{parse_bin_layout(name)})
+      game.get_viewport().set_bin_layout(*layout);
+    else
+      Logger().warn() << "Unknown ARCHA_BIN_LAYOUT " << name << '\n';
+  }
+
   game.init({1280, 720}, "Archa Engine", static_cast<float>(1) / 1);
   // game.init({1281, 720}, "Archa Engine", static_cast<float>(1) / 1);
   game.run();
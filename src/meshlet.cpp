@@ -0,0 +1,107 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Archa {
+
+static Meshlet build_meshlet(const std::vector<Vertex> &vertices,
+                             const std::vector<Triangle> &triangles,
+                             uint first_triangle, uint triangle_count) {
+  Meshlet meshlet{.first_triangle = first_triangle,
+                  .triangle_count = triangle_count,
+                  .first_vertex = std::numeric_limits<uint>::max(),
+                  .last_vertex = 0};
+
+  std::vector<Vertex> meshlet_vertices{};
+  std::vector<glm::vec3> normals{};
+
+  meshlet_vertices.reserve(triangle_count * 3);
+  normals.reserve(triangle_count);
+
+  for (auto t{first_triangle}; t < first_triangle + triangle_count; t++) {
+    const auto &triangle{triangles[t]};
+
+    for (const auto i : triangle.i) {
+      meshlet.first_vertex = std::min(meshlet.first_vertex, i);
+      meshlet.last_vertex = std::max(meshlet.last_vertex, i + 1);
+
+      meshlet_vertices.push_back(vertices[i]);
+    }
+
+    // faces wound this way are the ones process_triangle keeps
+    const glm::vec3 v0{vertices[triangle.i[0]]};
+    const glm::vec3 v1{vertices[triangle.i[1]]};
+    const glm::vec3 v2{vertices[triangle.i[2]]};
+
+    const auto normal{glm::cross(v1 - v0, v2 - v0)};
+
+    const auto length{glm::length(normal)};
+
+    if (length > 0.0f)
+      normals.push_back(normal / length);
+  }
+
+  meshlet.bounds = BoundingVolume::from_points(meshlet_vertices);
+
+  if (normals.empty())
+    return meshlet;
+
+  glm::vec3 axis{0.0f};
+
+  for (const auto &normal : normals)
+    axis += normal;
+
+  const auto axis_length{glm::length(axis)};
+
+  if (axis_length == 0.0f)
+    return meshlet;
+
+  axis /= axis_length;
+
+  auto min_dot{1.0f};
+
+  for (const auto &normal : normals)
+    min_dot = std::min(min_dot, glm::dot(axis, normal));
+
+  meshlet.cone_axis = axis;
+
+  if (min_dot > 0.0f)
+    meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+
+  return meshlet;
+}
+
+std::vector<Meshlet> Meshlet::build(const std::vector<Vertex> &vertices,
+                                    const std::vector<Triangle> &triangles) {
+  std::vector<Meshlet> meshlets{};
+
+  const auto triangle_count{static_cast<uint>(triangles.size())};
+
+  for (uint first{0}; first < triangle_count; first += MAX_TRIANGLES)
+    meshlets.push_back(build_meshlet(
+        vertices, triangles, first,
+        std::min(MAX_TRIANGLES, triangle_count - first)));
+
+  return meshlets;
+}
+
+bool Meshlet::is_culled(const Frustum &frustum,
+                        const glm::vec3 &camera_position,
+                        bool is_mirrored) const {
+  if (bounds.is_outside(frustum))
+    return true;
+
+  if (cone_cutoff >= 1.0f)
+    return false;
+
+  // back-facing if no point of the bounding sphere can see the front of any
+  // normal in the cone
+  const auto view{bounds.centre - camera_position};
+  const auto axis{is_mirrored ? -cone_axis : cone_axis};
+
+  return glm::dot(view, axis) >=
+         cone_cutoff * glm::length(view) + bounds.radius;
+}
+
+} // namespace Archa
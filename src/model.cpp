@@ -70,18 +70,6 @@ static void set_tex_coords(const tinyobj::index_t &idx, Triangle &triangle,
   }
 }
 
-static glm::vec2 wrap_uv(const glm::vec2 &uv) {
-  glm::vec2 result{std::fmod(uv.x, 1.0f), std::fmod(uv.y, 1.0f)};
-
-  if (result.x < 0.0f)
-    result.x += 1.0f;
-
-  if (result.y < 0.0f)
-    result.y += 1.0f;
-
-  return result;
-}
-
 static glm::vec3 calculate_triangle_normal(const glm::vec3 &v1,
                                            const glm::vec3 &v2,
                                            const glm::vec3 &v3) {
@@ -152,11 +140,10 @@ void Model::load(const std::filesystem::path &file_path) {
           triangle.diffuse_texture = ResourceManager::load<Image>(
               diffuse_texture_path.string(), diffuse_texture_path);
 
-          for (uint i{0}; i < triangle.uvs.size(); i++) {
-            triangle.uvs[i] = wrap_uv(triangle.uvs[i]);
-
+          // the sampler repeats coordinates outside [0, 1), so they are
+          // left unwrapped and stay continuous across each triangle
+          for (uint i{0}; i < triangle.uvs.size(); i++)
             triangle.uvs[i].y = 1.0f - triangle.uvs[i].y;
-          }
         }
 
         std::swap(triangle.i[1], triangle.i[2]);
@@ -179,9 +166,16 @@ void Model::load(const std::filesystem::path &file_path) {
     }
   }
 
+  compute_bounds();
+
   Logger().info() << "Loaded model: " << file_path << ", " << vertices.size()
-                  << " vertices, " << triangles.size() << " triangles"
-                  << '\n';
+                  << " vertices, " << triangles.size() << " triangles, "
+                  << meshlets.size() << " meshlets" << '\n';
+}
+
+void Model::compute_bounds() {
+  bounds = BoundingVolume::from_points(vertices);
+  meshlets = Meshlet::build(vertices, triangles);
 }
 
 } // namespace Archa
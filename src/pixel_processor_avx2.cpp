@@ -0,0 +1,41 @@
+#include "pixel_processor.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+void PixelProcessor::init_avx2() {
+  quad_x_vec256 = AVX2::set_ints(3, 2, 1, 0, 3, 2, 1, 0);
+
+  for (uint i{0}; i < 3; i++) {
+    const auto &delta_w{rt.delta_w[i]};
+
+    delta_w_x_init_vec256s[i] = AVX2::set_ints(
+        delta_w.x * 7, delta_w.x * 6, delta_w.x * 5, delta_w.x * 4,
+        delta_w.x * 3, delta_w.x * 2, delta_w.x, 0);
+
+    delta_w_x_step_vec256s[i] = AVX2::set_int(delta_w.x * AVX2::LANE_WIDTH);
+
+    delta_w_quad_init_vec256s[i] = AVX2::set_ints(
+        delta_w.x * 3 + delta_w.y, delta_w.x * 2 + delta_w.y,
+        delta_w.x + delta_w.y, delta_w.y, delta_w.x * 3, delta_w.x * 2,
+        delta_w.x, 0);
+
+    delta_w_quad_step_vec256s[i] = AVX2::set_int(delta_w.x * QUAD_WIDTH<AVX2>);
+  }
+}
+
+void PixelProcessor::iterate_pixels_avx2(int y) {
+  iterate_pixels<AVX2>(y, delta_w_x_init_vec256s, delta_w_x_step_vec256s);
+}
+
+void PixelProcessor::iterate_quads_avx2(int y) {
+  iterate_quads<AVX2>(y, quad_x_vec256, delta_w_quad_init_vec256s,
+                      delta_w_quad_step_vec256s);
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
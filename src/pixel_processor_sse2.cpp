@@ -0,0 +1,78 @@
+#include "pixel_processor.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+
+void PixelProcessor::init_sse2() {
+  w_row_seq_vec =
+      SSE2::set_ints(0, tile.w_row[2], tile.w_row[1], tile.w_row[0]);
+
+  delta_w_x_seq_vec =
+      SSE2::set_ints(0, rt.delta_w[2].x, rt.delta_w[1].x, rt.delta_w[0].x);
+
+  delta_w_y_seq_vec =
+      SSE2::set_ints(0, rt.delta_w[2].y, rt.delta_w[1].y, rt.delta_w[0].y);
+
+  quad_x_vec = SSE2::set_ints(1, 0, 1, 0);
+
+  for (uint i{0}; i < 3; i++) {
+    const auto &delta_w{rt.delta_w[i]};
+
+    delta_w_x_init_vecs[i] =
+        SSE2::set_ints(delta_w.x * 3, delta_w.x * 2, delta_w.x, 0);
+
+    delta_w_x_step_vecs[i] = SSE2::set_int(delta_w.x * SSE2::LANE_WIDTH);
+
+    delta_w_quad_init_vecs[i] = SSE2::set_ints(delta_w.x + delta_w.y, delta_w.y,
+                                               delta_w.x, 0);
+
+    delta_w_quad_step_vecs[i] = SSE2::set_int(delta_w.x * QUAD_WIDTH<SSE2>);
+  }
+}
+
+void PixelProcessor::start_row_sse2(int min_x) {
+  was_inside = false;
+  is_outside_right = false;
+
+  w_seq_vec = SSE2::add_ints(
+      w_row_seq_vec,
+      SSE2::multiply_ints(delta_w_x_seq_vec,
+                          SSE2::set_int(min_x - tile.box.min.x)));
+}
+
+void PixelProcessor::iterate_pixels_sse2(int y) {
+  iterate_pixels<SSE2>(y, delta_w_x_init_vecs, delta_w_x_step_vecs);
+}
+
+void PixelProcessor::iterate_quads_sse2(int y) {
+  iterate_quads<SSE2>(y, quad_x_vec, delta_w_quad_init_vecs,
+                      delta_w_quad_step_vecs);
+}
+
+void PixelProcessor::iterate_pixels_sequentially_sse2(int y) {
+  for (; x < max_x; x++) {
+    auto is_inside_mask{SSE2::move_mask_int8(
+        SSE2::compare_ints_gt(w_seq_vec, SSE2::minus_one_ints))};
+
+    auto is_inside{(is_inside_mask == 0xFFFF)};
+
+    if (is_inside) {
+      was_inside = true;
+
+      process_pixel({x, y});
+    }
+
+    else if (was_inside) {
+      return;
+    }
+
+    w_seq_vec = SSE2::add_ints(w_seq_vec, delta_w_x_seq_vec);
+  }
+}
+
+END_SSE2_TARGET
+#endif
+
+} // namespace Archa
@@ -1,6 +1,9 @@
 #include "rasteriser.hpp"
 
-#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <tuple>
 
 #include "bounding_box.hpp"
 #include "colour.hpp"
@@ -8,19 +11,47 @@
 #include "constants.hpp"
 #include "error.hpp"
 #include "frame_buffer.hpp"
+#include "frustum.hpp"
 #include "intrinsics.hpp"
 #include "logger.hpp"
 #include "pixel_processor.hpp"
 #include "render_triangle.hpp"
+#include "shading.hpp"
+#include "simd_level.hpp"
+#include "stamp_processor.hpp"
 #include "types.hpp"
 #include "util.hpp"
 #include "z_buffer.hpp"
 
 namespace Archa {
 
-void Rasteriser::compute_projection_transform() {
-  const auto &size{render_target.size};
+// vertices per transform task, a multiple of every SIMD lane width
+static constexpr uint VERTEX_BATCH_SIZE{4096};
+
+// widest SIMD lane the vertex cache transforms with
+static constexpr uint VERTEX_LANE_WIDTH{8};
+
+// how far past the screen centre, in pixels, vertices may land before the
+// triangle is clipped in x/y; keeps edge function products within int range
+static constexpr float GUARD_BAND_EXTENT{8192.0f};
+
+// largest edge function value PixelProcessor may step through in 32 bits,
+// leaving headroom for the partial sums in iterate_boxes
+static constexpr int64 MAX_EDGE_VALUE{1 << 29};
+
+// at whole pixels, the vertices and the pixel centres tested against them lie
+// in a square 2 * GUARD_BAND_EXTENT pixels wide, give or take a pixel or two of
+// rounding, and no edge function over a square exceeds the square's area
+static_assert(static_cast<int64>(2 * GUARD_BAND_EXTENT + 4) *
+                  static_cast<int64>(2 * GUARD_BAND_EXTENT + 4) <=
+              MAX_EDGE_VALUE);
 
+// triangles narrower than this, or covering less than this fraction of
+// their box, fill few lanes of a row and are traversed in 2D quads instead
+static constexpr int QUAD_MAX_WIDTH{16};
+static constexpr float QUAD_MAX_COVERAGE{0.25f};
+
+void Rasteriser::compute_projection_transform() {
   const auto height_over_width{static_cast<float>(size.y) /
                                static_cast<float>(size.x)};
 
@@ -40,69 +71,49 @@ void Rasteriser::compute_projection_transform() {
 }
 
 void Rasteriser::compute_screen_space_transform() {
-  const auto &size{render_target.size};
-
   const auto &half_width{static_cast<float>(size.x) / 2.0f};
   const auto &half_height{static_cast<float>(size.y) / 2.0f};
 
-  screen_space_transform[0][0] = half_width;
-  screen_space_transform[1][1] = -half_height;
-  screen_space_transform[3][0] = half_width;
-  screen_space_transform[3][1] = half_height;
-}
-
-void Rasteriser::clear_bin(const Bin &bin) {
-  auto &frame_buffer{render_target.frame_buffer};
-  auto &z_buffer{render_target.z_buffer};
-
-  const auto &bin_min{bin.get_pos()};
-  const auto &bin_max{bin_min + bin.get_size()};
-
-  const auto &fill_colour{bin.get_fill_colour()};
-
-  for (int y{bin_min.y}; y < bin_max.y; y++) {
-    auto x{bin_min.x};
-    auto z_buffer_index{y * render_target.size.x + x};
-
-#ifdef USING_SIMD_AVX2
-    for (; x < bin_max.x - (AVX2::LANE_WIDTH - 1);
-         x += AVX2::LANE_WIDTH, z_buffer_index += AVX2::LANE_WIDTH) {
-
-      ALIGN_AVX2 const AVX2::Array<Colour> colours{
-          fill_colour, fill_colour, fill_colour, fill_colour,
-          fill_colour, fill_colour, fill_colour, fill_colour};
-
-      frame_buffer.set_pixels({x, y}, colours);
-      z_buffer.clear_lane_avx2(z_buffer_index);
-    }
-#endif
+  // screen positions are fixed point with SUBPIXEL_BITS fractional bits
+  const auto subpixel_scale{static_cast<float>(1 << SUBPIXEL_BITS)};
 
-#ifdef USING_SIMD_SSE2
-    for (; x < bin_max.x - (SSE2::LANE_WIDTH - 1);
-         x += SSE2::LANE_WIDTH, z_buffer_index += SSE2::LANE_WIDTH) {
-      ALIGN_SSE2 const SSE2::Array<Colour> colours{fill_colour, fill_colour,
-                                                   fill_colour, fill_colour};
+  screen_space_transform[0][0] = half_width * subpixel_scale;
+  screen_space_transform[1][1] = -half_height * subpixel_scale;
+  screen_space_transform[3][0] = half_width * subpixel_scale;
+  screen_space_transform[3][1] = half_height * subpixel_scale;
 
-      frame_buffer.set_pixels({x, y}, colours);
-      z_buffer.clear_lane_sse2(z_buffer_index);
-    }
-#endif
-
-    for (; x < bin_max.x; x++, z_buffer_index++) {
-      frame_buffer.set_pixel({x, y}, fill_colour);
-      z_buffer.clear_single(z_buffer_index);
-    }
-  }
+  clipper.set_guard_band(glm::vec2{GUARD_BAND_EXTENT / half_width,
+                                   GUARD_BAND_EXTENT / half_height});
 }
 
-void Rasteriser::resize_bins(int bin_count) {
-  binner.split_bins(render_target.size, bin_count);
-  futures.resize(binner.get_bins().size());
+// the depth tested and stored for a vertex, smaller being nearer; float
+// buffers keep clip z, while the others take the normalised depth, which is
+// linear in screen space, working from w so reversed-Z keeps its precision
+//
+// triangles are clipped to the far plane as well as the near one, so every
+// format sees depths between the two, and none keeps what lies beyond far
+float Rasteriser::get_depth(const glm::vec4 &clip) const {
+  if (depth_format == DepthFormat::FLOAT32)
+    return clip.z;
+
+  const auto z_near{camera->get_z_near()};
+  const auto z_far{camera->get_z_far()};
+  const auto z_range{(z_far - z_near) * clip.w};
+
+  // 1 - depth, negated to keep nearer depths smaller
+  if (depth_format == DepthFormat::FLOAT32_REVERSED)
+    return -z_near * (z_far - clip.w) / z_range;
+
+  return z_far * (clip.w - z_near) / z_range;
 }
 
-void Rasteriser::create(const glm::ivec2 &size, int bin_count) {
-  render_target.create(size);
-  resize_bins(bin_count);
+void Rasteriser::create(const glm::ivec2 &size) {
+  this->size = size;
+
+  frame_buffer.create(size);
+  texture.create(static_cast<uint>(size.x), static_cast<uint>(size.y));
+
+  binner.split_bins(size, RenderTarget::TILE_SIZE);
 
   if (camera)
     compute_projection_transform();
@@ -116,229 +127,701 @@ void Rasteriser::set_camera(const Camera *camera) {
   compute_projection_transform();
 }
 
-static const std::vector<std::pair<uint, BoundingBox>> &
-split_bounding_box(const BoundingBox &box, const std::vector<Bin> &bins,
-                   const glm::ivec2 &screen_size) {
+void Rasteriser::set_visibility_buffer_enabled(bool is_enabled) {
+  is_visibility_buffer_enabled = is_enabled;
+}
+
+void Rasteriser::set_depth_prepass_enabled(bool is_enabled) {
+  is_depth_prepass_enabled = is_enabled;
+}
 
-  thread_local auto result{create_reserved_vector<std::pair<uint, BoundingBox>>(
-      std::thread::hardware_concurrency())};
+void Rasteriser::set_cost_ordering_enabled(bool is_enabled) {
+  is_cost_ordering_enabled = is_enabled;
+}
 
-  result.clear();
+void Rasteriser::set_bin_layout(BinLayout layout) {
+  binner.set_layout(layout);
+}
 
-  for (uint i{0}; i < bins.size(); i++) {
-    const auto &bin{bins[i]};
+void Rasteriser::set_depth_format(DepthFormat format) {
+  depth_format = format;
 
-    const auto &bin_min{glm::max({0, 0}, bins[i].get_pos())};
-    const auto &bin_max{glm::min(screen_size, bin_min + bin.get_size())};
+  for (auto &target : tile_targets)
+    target.z_buffer.create(target.size, depth_format);
+}
 
-    if (!box.overlaps(bin_min, bin_max))
-      continue;
+void Rasteriser::bin_triangle(uint queue_index, uint bin_index,
+                              RenderTriangle &render_triangle) {
+  auto &group{binner.get_render_bin_group(queue_index, bin_index)};
 
-    const auto &min{glm::max(box.min, bin_min)};
-    const auto &max{glm::min(box.max, bin_max)};
+  // a group that has used every id drops the rest of its triangles
+  if (group.size() > VisibilityBuffer::MAX_TRIANGLE_INDEX)
+    return;
 
-    result.emplace_back(i, BoundingBox{min, max});
-  }
+  render_triangle.id = VisibilityBuffer::pack_id(
+      queue_index, static_cast<uint>(group.size()));
 
-  return result;
+  group.push_back(render_triangle);
 }
 
-#ifdef USING_SIMD_AVX2
-void Rasteriser::iterate_boxes_avx2(
+void Rasteriser::iterate_boxes(
     const BoundingBox &box,
     const std::vector<std::pair<uint, BoundingBox>> &boxes,
     const std::array<int, 3> &w_row, const std::array<glm::ivec2, 3> &delta_w,
-    uint &i, RenderTriangle &render_triangle) {
+    uint i, uint queue_index, RenderTriangle &render_triangle) {
 
-  std::array<__m256i, 3> w_row_vec256{};
-  std::array<__m256i, 3> delta_w_vec256{};
+  for (; i < boxes.size(); i++) {
+    const auto &[bin_index, bin_box]{boxes[i]};
+    const auto &box_difference{bin_box.min - box.min};
 
-  const auto boxes_per_avx2_lane{AVX2::LANE_WIDTH / 2};
+    std::array<int, 3> w_row_new{};
 
-  if (boxes.size() >= boxes_per_avx2_lane) {
-    for (uint i{0}; i < 3; i++) {
-      w_row_vec256[i] =
-          AVX2::set_ints(w_row[i], w_row[i], w_row[i], w_row[i], 0, 0, 0, 0);
+    for (uint i{0}; i < w_row_new.size(); i++) {
+      const auto &new_delta_w{delta_w[i] * box_difference};
 
-      delta_w_vec256[i] = AVX2::set_ints(
-          delta_w[i].x, delta_w[i].x, delta_w[i].x, delta_w[i].x, delta_w[i].y,
-          delta_w[i].y, delta_w[i].y, delta_w[i].y);
+      w_row_new[i] = w_row[i] + new_delta_w.y + new_delta_w.x;
     }
+
+    render_triangle.box = bin_box;
+    render_triangle.w_row = w_row_new;
+
+    bin_triangle(queue_index, bin_index, render_triangle);
   }
+}
+
+// edge function of p against a->b, wide enough for any sub-pixel position
+// within the guard band
+static int64 edge_cross(const glm::ivec2 &a, const glm::ivec2 &b,
+                        const glm::ivec2 &p) {
+  const auto ab_x{static_cast<int64>(b.x) - a.x};
+  const auto ab_y{static_cast<int64>(b.y) - a.y};
+  const auto ap_x{static_cast<int64>(p.x) - a.x};
+  const auto ap_y{static_cast<int64>(p.y) - a.y};
+
+  return ab_x * ap_y - ab_y * ap_x;
+}
 
-  for (; static_cast<int>(i) < std::ssize(boxes) - (boxes_per_avx2_lane - 1);
-       i += boxes_per_avx2_lane) {
-    __m256i box_min_vec256{AVX2::set_ints(box.min.x, box.min.x, box.min.x,
-                                          box.min.x, box.min.y, box.min.y,
-                                          box.min.y, box.min.y)};
+static bool is_top_left(const glm::ivec2 &start, const glm::ivec2 &end) {
+  const auto edge{end - start};
 
-    __m256i boxes_min_vec256{
-        AVX2::set_ints(boxes[i + 3].second.min.x, boxes[i + 2].second.min.x,
-                       boxes[i + 1].second.min.x, boxes[i].second.min.x,
-                       boxes[i + 3].second.min.y, boxes[i + 2].second.min.y,
-                       boxes[i + 1].second.min.y, boxes[i].second.min.y)};
+  bool is_top_edge{edge.y == 0 && edge.x > 0};
+  bool is_left_edge{edge.y < 0};
 
-    __m256i box_difference_vec256{
-        AVX2::subtract_ints(boxes_min_vec256, box_min_vec256)};
+  return is_top_edge || is_left_edge;
+}
+
+// drops the lowest bits of a sub-pixel position, rounding to nearest
+static glm::ivec2 reduce_precision(const glm::ivec2 &v, int bits) {
+  if (bits == 0)
+    return v;
 
-    ALIGN_SSE2 std::array<std::array<int, 4>, 3> new_w_row{};
+  const auto half{1 << (bits - 1)};
 
-    for (uint j{0}; j < 3; j++) {
-      const auto &new_w_row_vec256{AVX2::add_ints(
-          w_row_vec256[j],
-          AVX2::multiply_ints(delta_w_vec256[j], box_difference_vec256))};
+  return {(v.x + half) >> bits, (v.y + half) >> bits};
+}
 
-      const auto &new_w_row_vec{
-          SSE2::add_ints(AVX2::extract_ints128<0>(new_w_row_vec256),
-                         AVX2::extract_ints128<1>(new_w_row_vec256))};
+// pixels whose centres can fall inside the triangle, max exclusive
+static BoundingBox compute_pixel_box(const std::array<glm::ivec2, 3> &v,
+                                     int precision) {
+  const auto min{glm::min(v[0], glm::min(v[1], v[2]))};
+  const auto max{glm::max(v[0], glm::max(v[1], v[2]))};
 
-      SSE2::store_ints(new_w_row[j].data(), new_w_row_vec);
-    }
+  const auto scale{1 << precision};
+  const auto half{scale >> 1};
 
-    for (uint j{0}; j < boxes_per_avx2_lane; j++) {
-      const auto box_index{i + j};
+  return {{(min.x - half + scale - 1) >> precision,
+           (min.y - half + scale - 1) >> precision},
+          {((max.x - half) >> precision) + 1,
+           ((max.y - half) >> precision) + 1}};
+}
 
-      const std::array<int, 3> w_row_new_j{new_w_row[0][j], new_w_row[1][j],
-                                           new_w_row[2][j]};
+// rounds as VertexCache does, so clipped and unclipped triangles meet on the
+// same sub-pixels
+static glm::ivec2 project_to_screen(const glm::vec4 &clip,
+                                    const glm::mat4 &screen_space_transform) {
+  const auto screen{screen_space_transform * clip};
 
-      render_triangle.box = boxes[box_index].second;
-      render_triangle.w_row = w_row_new_j;
+  return glm::ivec2{glm::roundEven(glm::vec2{screen} / screen.w)};
+}
 
-      binner.get_render_bin_group(boxes[box_index].first)
-          .push_back(render_triangle);
-    }
+static glm::vec4 colour_to_vec4(const Colour &colour) {
+  return {colour.r, colour.g, colour.b, colour.a};
+}
+
+static Colour vec4_to_colour(const glm::vec4 &colour) {
+  return {static_cast<uint8>(colour.x + 0.5f),
+          static_cast<uint8>(colour.y + 0.5f),
+          static_cast<uint8>(colour.z + 0.5f),
+          static_cast<uint8>(colour.w + 0.5f)};
+}
+
+// the barycentric weight of vertex i is its edge function over the area, so
+// an attribute's plane is the weighted sum of the edge functions' planes;
+// summed in double, as the edge functions at the box's corner can be far
+// larger than the area for slivers
+static AttributePlane
+compute_attribute_plane(const std::array<float, 3> &values,
+                        const std::array<int, 3> &w_row,
+                        const std::array<glm::ivec2, 3> &delta_w,
+                        float area) {
+  double a{};
+  double b{};
+  double c{};
+
+  for (uint i{0}; i < values.size(); i++) {
+    const auto value{static_cast<double>(values[i]) /
+                     static_cast<double>(area)};
+
+    a += delta_w[i].x * value;
+    b += delta_w[i].y * value;
+    c += w_row[i] * value;
   }
+
+  return {static_cast<float>(a), static_cast<float>(b), static_cast<float>(c)};
 }
-#endif
 
-void Rasteriser::iterate_boxes(
-    const BoundingBox &box,
-    const std::vector<std::pair<uint, BoundingBox>> &boxes,
-    const std::array<int, 3> &w_row, const std::array<glm::ivec2, 3> &delta_w,
-    uint i, RenderTriangle &render_triangle) {
+void Rasteriser::setup_triangle(const Triangle &triangle,
+                                const std::array<Colour, 3> &colours,
+                                const std::array<glm::vec4, 3> &clip,
+                                const std::array<glm::ivec2, 3> &v,
+                                uint queue_index) {
 
-  for (; i < boxes.size(); i++) {
-    const auto &[bin_index, bin_box]{boxes[i]};
-    const auto &box_difference{bin_box.min - box.min};
+  auto box{compute_pixel_box(v, SUBPIXEL_BITS)};
 
-    std::array<int, 3> w_row_new{};
+  if (!box.overlaps({0, 0}, size))
+    return;
 
-    for (uint i{0}; i < w_row_new.size(); i++) {
-      const auto &new_delta_w{delta_w[i] * box_difference};
+  // large triangles give up sub-pixel bits until every edge function in
+  // their on-screen box fits the 32 bit stepping in PixelProcessor
+  std::array<glm::ivec2, 3> v_fixed{};
+  std::array<int64, 3> w_row{};
+  std::array<glm::ivec2, 3> delta_w{};
 
-      w_row_new[i] = w_row[i] + new_delta_w.y + new_delta_w.x;
+  int64 area{};
+  int precision{SUBPIXEL_BITS};
+
+  for (;; precision--) {
+    for (uint i{0}; i < v.size(); i++)
+      v_fixed[i] = reduce_precision(v[i], SUBPIXEL_BITS - precision);
+
+    area = edge_cross(v_fixed[0], v_fixed[1], v_fixed[2]);
+
+    if (area <= 0)
+      return;
+
+    box = compute_pixel_box(v_fixed, precision);
+    box = {glm::max(box.min, {0, 0}), glm::min(box.max, size)};
+
+    const auto half{(1 << precision) >> 1};
+
+    const auto pixel_centre{[&](const glm::ivec2 &pixel) {
+      return glm::ivec2{pixel.x * (1 << precision) + half,
+                        pixel.y * (1 << precision) + half};
+    }};
+
+    const std::array<glm::ivec2, 4> corners{
+        pixel_centre(box.min), pixel_centre({box.max.x, box.min.y}),
+        pixel_centre({box.min.x, box.max.y}), pixel_centre(box.max)};
+
+    auto fits{true};
+
+    for (uint i{0}; i < 3; i++) {
+      const auto &a{v_fixed[(i + 1) % 3]};
+      const auto &b{v_fixed[(i + 2) % 3]};
+
+      // folding the top-left bias in before the shift keeps the floored
+      // value's sign exact, and stepping a whole pixel moves it by an integer
+      const auto bias{is_top_left(a, b) ? 0 : -1};
+
+      w_row[i] = (edge_cross(a, b, pixel_centre(box.min)) + bias) >> precision;
+      delta_w[i] = {a.y - b.y, b.x - a.x};
+
+      for (const auto &corner : corners)
+        fits &= std::abs((edge_cross(a, b, corner) + bias) >> precision) <=
+                MAX_EDGE_VALUE;
     }
 
-    render_triangle.box = bin_box;
-    render_triangle.w_row = w_row_new;
+    if (fits)
+      break;
 
-    binner.get_render_bin_group(bin_index).push_back(render_triangle);
+    // whole pixels always fit within the guard band, see MAX_EDGE_VALUE, so
+    // this only drops a triangle that slipped past the clipper
+    if (precision == 0)
+      return;
   }
-}
 
-static int edge_cross(const glm::ivec2 &a, const glm::ivec2 &b,
-                      const glm::ivec2 &p) {
-  const glm::ivec2 &ab{b - a};
-  const glm::ivec2 &ap{p - a};
+  if (box.min.x >= box.max.x || box.min.y >= box.max.y)
+    return;
+
+  const auto &boxes{binner.find_bins(box)};
+
+  if (boxes.empty())
+    return;
+
+  const std::array<int, 3> w_row_32{static_cast<int>(w_row[0]),
+                                    static_cast<int>(w_row[1]),
+                                    static_cast<int>(w_row[2])};
+
+  const auto box_size{box.max - box.min};
+
+  const auto pixel_area{static_cast<float>(area) * 0.5f /
+                        static_cast<float>(1 << precision) /
+                        static_cast<float>(1 << precision)};
 
-  return ab.x * ap.y - ab.y * ap.x;
+  const auto is_quad_traversal{
+      box_size.x < QUAD_MAX_WIDTH ||
+      pixel_area < static_cast<float>(box_size.x) *
+                       static_cast<float>(box_size.y) * QUAD_MAX_COVERAGE};
+
+  RenderTriangle render_triangle{.triangle = triangle,
+                                 .delta_w = delta_w,
+                                 .origin = box.min,
+                                 .is_quad_traversal = is_quad_traversal};
+
+  const auto edge_area{static_cast<float>(area) /
+                       static_cast<float>(1 << precision)};
+
+  const auto get_plane{[&](const std::array<float, 3> &values) {
+    return compute_attribute_plane(values, w_row_32, delta_w, edge_area);
+  }};
+
+  const std::array<float, 3> depths{get_depth(clip[0]), get_depth(clip[1]),
+                                    get_depth(clip[2])};
+
+  render_triangle.z_plane = get_plane(depths);
+  render_triangle.min_z = std::min({depths[0], depths[1], depths[2]});
+
+  if (triangle.diffuse_texture) {
+    render_triangle.inv_w_plane =
+        get_plane({1.0f / clip[0].w, 1.0f / clip[1].w, 1.0f / clip[2].w});
+
+    for (uint i{0}; i < render_triangle.uv_over_w_planes.size(); i++)
+      render_triangle.uv_over_w_planes[i] =
+          get_plane({triangle.uvs[0][static_cast<int>(i)] / clip[0].w,
+                     triangle.uvs[1][static_cast<int>(i)] / clip[1].w,
+                     triangle.uvs[2][static_cast<int>(i)] / clip[2].w});
+  } else {
+    const std::array<glm::vec4, 3> channels{colour_to_vec4(colours[0]),
+                                            colour_to_vec4(colours[1]),
+                                            colour_to_vec4(colours[2])};
+
+    for (int c{0}; c < RGBA_CHANNEL_COUNT; c++)
+      render_triangle.colour_planes[static_cast<uint>(c)] =
+          get_plane({channels[0][c], channels[1][c], channels[2][c]});
+  }
+
+  uint i{0};
+
+#ifdef USING_SIMD_AVX2
+  if (get_simd_level() >= SimdLevel::AVX2)
+    iterate_boxes_avx2(box, boxes, w_row_32, delta_w, i, queue_index,
+                       render_triangle);
+#endif
+
+  iterate_boxes(box, boxes, w_row_32, delta_w, i, queue_index,
+                render_triangle);
 }
 
-static bool is_top_left(const glm::ivec2 &start, const glm::ivec2 &end) {
-  const auto edge{end - start};
+void Rasteriser::process_clipped_triangle(const std::vector<Vertex> &vertices,
+                                          const VertexCache &vertex_cache,
+                                          const Triangle &triangle,
+                                          uint8 planes, uint queue_index) {
+  ClipPolygon polygon{.count = 3};
 
-  bool is_top_edge{edge.y == 0 && edge.x > 0};
-  bool is_left_edge{edge.y < 0};
+  for (uint i{0}; i < 3; i++)
+    polygon.vertices[i] = {vertex_cache.get_clip(triangle.i[i]),
+                           colour_to_vec4(vertices[triangle.i[i]].colour),
+                           triangle.uvs[i], triangle.normals[i]};
 
-  return is_top_edge || is_left_edge;
+  clipper.clip(polygon, planes);
+
+  const auto &a{polygon.vertices[0]};
+
+  for (uint i{1}; i + 1 < polygon.count; i++) {
+    const auto &b{polygon.vertices[i]};
+    const auto &c{polygon.vertices[i + 1]};
+
+    auto clipped_triangle{triangle};
+
+    clipped_triangle.uvs = {a.uv, b.uv, c.uv};
+    clipped_triangle.normals = {a.normal, b.normal, c.normal};
+
+    const std::array<Colour, 3> colours{vec4_to_colour(a.colour),
+                                        vec4_to_colour(b.colour),
+                                        vec4_to_colour(c.colour)};
+
+    const std::array<glm::vec4, 3> clip{a.clip, b.clip, c.clip};
+
+    const std::array<glm::ivec2, 3> v{
+        project_to_screen(a.clip, screen_space_transform),
+        project_to_screen(b.clip, screen_space_transform),
+        project_to_screen(c.clip, screen_space_transform)};
+
+    setup_triangle(clipped_triangle, colours, clip, v, queue_index);
+  }
 }
 
 void Rasteriser::process_triangle(const std::vector<Vertex> &vertices,
-                                  Triangle triangle,
-                                  const glm::mat4 &transform) {
+                                  const VertexCache &vertex_cache,
+                                  const Triangle &triangle, uint queue_index) {
+
+  const std::array<uint8, 3> outcodes{vertex_cache.get_outcode(triangle.i[0]),
+                                      vertex_cache.get_outcode(triangle.i[1]),
+                                      vertex_cache.get_outcode(triangle.i[2])};
+
+  // every vertex is outside the same plane
+  if (outcodes[0] & outcodes[1] & outcodes[2])
+    return;
+
+  const auto planes{
+      static_cast<uint8>(outcodes[0] | outcodes[1] | outcodes[2])};
 
-  const auto vp{projection_transform * transform};
+  if (planes) {
+    process_clipped_triangle(vertices, vertex_cache, triangle, planes,
+                             queue_index);
+    return;
+  }
 
   const auto &v0{vertices[triangle.i[0]]};
   const auto &v1{vertices[triangle.i[1]]};
   const auto &v2{vertices[triangle.i[2]]};
 
-  // for (auto &normal : triangle.normals)
-  // normal = glm::normalize(glm::vec3{transform * glm::vec4{normal, 0.0f}});
-
-  const std::array<glm::vec4, 3> clip{vp * glm::vec4{v0, 1.0f},
-                                      vp * glm::vec4{v1, 1.0f},
-                                      vp * glm::vec4{v2, 1.0f}};
+  const std::array<glm::vec4, 3> clip{vertex_cache.get_clip(triangle.i[0]),
+                                      vertex_cache.get_clip(triangle.i[1]),
+                                      vertex_cache.get_clip(triangle.i[2])};
 
   const std::array<Colour, 3> colours{v0.colour, v1.colour, v2.colour};
 
-  triangle.uvs = {triangle.uvs[0], triangle.uvs[1], triangle.uvs[2]};
+  const std::array<glm::ivec2, 3> v{vertex_cache.get_screen(triangle.i[0]),
+                                    vertex_cache.get_screen(triangle.i[1]),
+                                    vertex_cache.get_screen(triangle.i[2])};
 
-  triangle.normals = {triangle.normals[0], triangle.normals[1],
-                      triangle.normals[2]};
+  setup_triangle(triangle, colours, clip, v, queue_index);
+}
 
-  const std::array<glm::vec4, 3> screen{screen_space_transform * clip[0],
-                                        screen_space_transform * clip[1],
-                                        screen_space_transform * clip[2]};
+void Rasteriser::transform_vertices(const Model &model, uint visible_index,
+                                    const glm::mat4 &vp, uint first,
+                                    uint last, BS::thread_pool &thread_pool) {
+  for (; first < last; first += VERTEX_BATCH_SIZE) {
+    const auto batch_last{std::min(last, first + VERTEX_BATCH_SIZE)};
+
+    futures.push_back(thread_pool.submit_task(
+        [this, &model, visible_index, vp, first, batch_last] {
+          vertex_caches[visible_index].transform(model.vertices, vp,
+                                                 screen_space_transform,
+                                                 clipper, first, batch_last);
+        }));
+  }
+}
 
-  const std::array<glm::ivec2, 3> v{glm::ivec2{screen[0] / screen[0].w},
-                                    glm::ivec2{screen[1] / screen[1].w},
-                                    glm::ivec2{screen[2] / screen[2].w}};
+void Rasteriser::process_triangles(const Scene &scene, uint queue_index,
+                                   uint first_triangle, uint last_triangle) {
 
-  const auto &area{edge_cross(v[0], v[1], v[2])};
+  for (uint i{0}; i < binner.get_bins().size(); i++)
+    binner.get_render_bin_group(queue_index, i).clear();
 
-  if (area <= 0)
+  if (first_triangle >= last_triangle)
     return;
 
-  const auto &box{BoundingBox::from_points(v[0], v[1], v[2])};
+  const auto offset{std::upper_bound(std::begin(triangle_offsets),
+                                     std::end(triangle_offsets),
+                                     first_triangle) -
+                    1};
+
+  auto meshlet_index{
+      static_cast<uint>(std::distance(std::begin(triangle_offsets), offset))};
+
+  auto triangle_index{first_triangle};
 
-  if (!box.overlaps({0, 0}, render_target.size))
+  while (triangle_index < last_triangle) {
+    const auto &[instance_index, model_meshlet_index]{
+        visible_meshlets[meshlet_index]};
+
+    const auto &model_instance{
+        scene.model_instances[visible_instances[instance_index]]};
+
+    const auto &model{model_instance.model};
+    const auto &meshlet{model.meshlets[model_meshlet_index]};
+    const auto &vertex_cache{vertex_caches[instance_index]};
+
+    const auto meshlet_first{triangle_offsets[meshlet_index]};
+    const auto meshlet_last{
+        std::min(last_triangle, meshlet_first + meshlet.triangle_count)};
+
+    for (; triangle_index < meshlet_last; triangle_index++)
+      process_triangle(model.vertices, vertex_cache,
+                       model.triangles[meshlet.first_triangle +
+                                       triangle_index - meshlet_first],
+                       queue_index);
+
+    meshlet_index++;
+  }
+}
+
+// how much of a block of pixels a triangle covers
+enum BlockCoverage : uint8 { BLOCK_EMPTY, BLOCK_PARTIAL, BLOCK_FULL };
+
+// a horizontal run of blocks with the same coverage
+struct BlockRun {
+  int min_x{}, max_x{};
+  bool is_covered{};
+};
+
+static BlockCoverage classify_block(const TileTriangle &tile,
+                                    const glm::ivec2 &min,
+                                    const glm::ivec2 &max) {
+  const auto &rt{*tile.triangle};
+  const auto offset{min - tile.box.min};
+
+  auto is_full{true};
+
+  // edge functions are linear, so their extremes over the block lie at the
+  // centres of its corner pixels
+  for (uint i{0}; i < 3; i++) {
+    const auto &delta_w{rt.delta_w[i]};
+
+    const auto w{tile.w_row[i] + delta_w.x * offset.x + delta_w.y * offset.y};
+    const auto span_x{delta_w.x * (max.x - 1 - min.x)};
+    const auto span_y{delta_w.y * (max.y - 1 - min.y)};
+
+    if (w + std::max(span_x, 0) + std::max(span_y, 0) < 0)
+      return BLOCK_EMPTY;
+
+    is_full &= w + std::min(span_x, 0) + std::min(span_y, 0) >= 0;
+  }
+
+  return is_full ? BLOCK_FULL : BLOCK_PARTIAL;
+}
+
+// runs of non-empty blocks within [min_x, max_x) of one row of blocks
+static const std::vector<BlockRun> &
+find_block_runs(const TileTriangle &tile, int min_x, int max_x, int min_y,
+                int max_y) {
+
+  thread_local std::vector<BlockRun> result{};
+
+  result.clear();
+
+  for (auto x{min_x}; x < max_x;) {
+    const auto block_max_x{
+        std::min(max_x, (x / ZBuffer::BLOCK_SIZE + 1) * ZBuffer::BLOCK_SIZE)};
+
+    const auto coverage{
+        classify_block(tile, {x, min_y}, {block_max_x, max_y})};
+
+    if (coverage != BLOCK_EMPTY) {
+      const auto is_covered{coverage == BLOCK_FULL};
+
+      if (!result.empty() && result.back().max_x == x &&
+          result.back().is_covered == is_covered)
+        result.back().max_x = block_max_x;
+      else
+        result.push_back({x, block_max_x, is_covered});
+    }
+
+    x = block_max_x;
+  }
+
+  return result;
+}
+
+void Rasteriser::render_triangle(RenderTarget &target, const TileTriangle &tile,
+                                 RenderPass pass) {
+  const auto &rt{*tile.triangle};
+  const auto &box{tile.box};
+
+  auto &z_buffer{target.z_buffer};
+
+  // fixed-point coverage can let a depth land a rounding step nearer than
+  // any vertex, which an equal test cannot tolerate
+  if (pass != PASS_COLOUR_EQUAL && z_buffer.is_occluded(box, rt.min_z))
     return;
 
-  const auto &boxes{
-      split_bounding_box(box, binner.get_bins(), render_target.size)};
+  if (StampProcessor::fits(box)) {
+    target.resolve_clears(box.min, box.max);
+    StampProcessor{target}.render(tile, pass);
 
-  if (boxes.empty())
     return;
+  }
 
-  const auto &p0{box.min};
+  PixelProcessor pixel_processor{target, tile, pass};
 
-  const std::array<int, 3> w_row{edge_cross(v[1], v[2], p0),
-                                 edge_cross(v[2], v[0], p0),
-                                 edge_cross(v[0], v[1], p0)};
+  // the pre-pass pair must visit every pixel through the same lane path so
+  // both passes interpolate bit-identical depths
+  const auto is_narrowing_spans{pass != PASS_DEPTH &&
+                                pass != PASS_COLOUR_EQUAL};
 
-  const std::array<glm::ivec2, 3> delta_w{
-      glm::ivec2(v[1].y - v[2].y, v[2].x - v[1].x),
-      glm::ivec2(v[2].y - v[0].y, v[0].x - v[2].x),
-      glm::ivec2(v[0].y - v[1].y, v[1].x - v[0].x)};
+  auto y{box.min.y};
 
-  const std::array<int8, 3> bias{
-      static_cast<int8>(is_top_left(v[1], v[2]) ? 0 : -1),
-      static_cast<int8>(is_top_left(v[2], v[0]) ? 0 : -1),
-      static_cast<int8>(is_top_left(v[0], v[1]) ? 0 : -1)};
+  while (y < box.max.y) {
+    const auto block_row_max_y{std::min(
+        box.max.y, (y / ZBuffer::BLOCK_SIZE + 1) * ZBuffer::BLOCK_SIZE)};
 
-  RenderTriangle render_triangle{.triangle = triangle,
-                                 .colours = colours,
-                                 .area = area,
-                                 .bias = bias,
-                                 .clip = clip,
-                                 .delta_w = delta_w};
+    auto min_x{box.min.x};
+    auto max_x{box.max.x};
 
-  uint i{0};
+    if (is_narrowing_spans)
+      std::tie(min_x, max_x) =
+          z_buffer.find_visible_span(y, box.min.x, box.max.x, rt.min_z);
 
-#ifdef USING_SIMD_AVX2
-  iterate_boxes_avx2(box, boxes, w_row, delta_w, i, render_triangle);
-#endif
+    target.resolve_clears({min_x, y}, {max_x, block_row_max_y});
+
+    const auto &runs{find_block_runs(tile, min_x, max_x, y, block_row_max_y)};
+
+    if (rt.is_quad_traversal) {
+      for (; y + 1 < block_row_max_y; y += 2) {
+        for (const auto &run : runs)
+          pixel_processor.iterate_quad_x(y, run.min_x, run.max_x,
+                                         run.is_covered);
+
+        pixel_processor.step_y();
+        pixel_processor.step_y();
+      }
+    }
+
+    for (; y < block_row_max_y; y++) {
+      for (const auto &run : runs)
+        pixel_processor.iterate_x(y, run.min_x, run.max_x, run.is_covered);
+
+      pixel_processor.step_y();
+    }
+  }
+}
+
+void Rasteriser::shade_tile(RenderTarget &target, uint bin_index,
+                            const glm::ivec2 &tile_min,
+                            const glm::ivec2 &tile_max) {
+  const auto &visibility_buffer{target.visibility_buffer};
+  const auto tile_size{tile_max - tile_min};
+
+  for (auto y{0}; y < tile_size.y; y++) {
+    for (auto x{0}; x < tile_size.x; x++) {
+      const auto id{visibility_buffer.get({x, y})};
+
+      if (id == VisibilityBuffer::NO_ID)
+        continue;
+
+      const auto [queue_index, triangle_index]{VisibilityBuffer::unpack_id(id)};
+
+      // binned triangles are still in screen coordinates
+      const auto &rt{
+          binner.get_render_bin_group(queue_index, bin_index)[triangle_index]};
+
+      const glm::vec2 offset{tile_min + glm::ivec2{x, y} - rt.origin};
+
+      target.frame_buffer.set_pixel({x, y}, shade_pixel(rt, offset));
+    }
+  }
+}
+
+// rt clipped to [tile_min, tile_max) and moved into the tile's coordinates;
+// the planes move with origin, so only the edge functions need stepping
+static TileTriangle move_to_tile(const RenderTriangle &rt,
+                                 const glm::ivec2 &tile_min,
+                                 const glm::ivec2 &tile_max) {
+  const auto min{glm::max(rt.box.min, tile_min)};
+  const auto max{glm::min(rt.box.max, tile_max)};
+  const auto box_difference{min - rt.box.min};
+
+  TileTriangle result{.triangle = &rt,
+                      .box = BoundingBox{min - tile_min, max - tile_min},
+                      .w_row = rt.w_row,
+                      .origin = rt.origin - tile_min};
+
+  for (uint i{0}; i < result.w_row.size(); i++) {
+    const auto delta_w{rt.delta_w[i] * box_difference};
+
+    result.w_row[i] += delta_w.y + delta_w.x;
+  }
+
+  return result;
+}
+
+void Rasteriser::render_bin(RenderTarget &target, uint bin_index,
+                            const std::vector<RenderPass> &passes) {
+  constexpr auto TILE_SIZE{RenderTarget::TILE_SIZE};
+
+  // the bin's triangles overlapping each tile, in the bin's order
+  thread_local std::vector<std::vector<const RenderTriangle *>> tile_groups{};
+  thread_local std::vector<TileTriangle> tile_triangles{};
+
+  const auto &bin{binner.get_bins()[bin_index]};
 
-  iterate_boxes(box, boxes, w_row, delta_w, i, render_triangle);
+  const auto bin_min{glm::max({0, 0}, bin.get_pos())};
+  const auto bin_max{glm::min(size, bin_min + bin.get_size())};
+  const auto tile_count{(bin_max - bin_min + TILE_SIZE - 1) / TILE_SIZE};
+
+  binner.sort_bin(bin_index);
+
+  tile_groups.resize(static_cast<uint>(tile_count.x * tile_count.y));
+
+  for (auto &group : tile_groups)
+    group.clear();
+
+  for (const auto *rt : binner.get_sorted_bin_group(bin_index)) {
+    const auto first{(rt->box.min - bin_min) / TILE_SIZE};
+    const auto last{(rt->box.max - 1 - bin_min) / TILE_SIZE};
+
+    for (auto y{first.y}; y <= last.y; y++)
+      for (auto x{first.x}; x <= last.x; x++)
+        tile_groups[static_cast<uint>(y * tile_count.x + x)].push_back(rt);
+  }
+
+  // each tile runs every pass in the target, then is written out once
+  for (auto y{0}; y < tile_count.y; y++) {
+    for (auto x{0}; x < tile_count.x; x++) {
+      const auto tile_min{bin_min + glm::ivec2{x, y} * TILE_SIZE};
+      const auto tile_max{glm::min(bin_max, tile_min + TILE_SIZE)};
+
+      const auto start{std::chrono::steady_clock::now()};
+
+      tile_triangles.clear();
+
+      const auto &group{tile_groups[static_cast<uint>(y * tile_count.x + x)]};
+
+      for (const auto *rt : group)
+        tile_triangles.push_back(move_to_tile(*rt, tile_min, tile_max));
+
+      target.clear(bin.get_fill_colour());
+
+      if (is_visibility_buffer_enabled)
+        target.visibility_buffer.clear({0, 0}, tile_max - tile_min);
+
+      for (const auto pass : passes)
+        for (const auto &tile : tile_triangles)
+          render_triangle(target, tile, pass);
+
+      target.resolve_colour_clears();
+
+      if (is_visibility_buffer_enabled)
+        shade_tile(target, bin_index, tile_min, tile_max);
+
+      frame_buffer.resolve(target.frame_buffer, tile_min, tile_max - tile_min);
+
+      const std::chrono::duration<float, std::micro> time{
+          std::chrono::steady_clock::now() - start};
+
+      // tiles line up with the binner's cells, which feed its cost map
+      binner.record_cell_time(tile_min, time.count());
+    }
+  }
 }
 
-void Rasteriser::render_triangle(RenderTriangle &rt) {
-  PixelProcessor pixel_processor{render_target, rt};
+void Rasteriser::render_bins(RenderTarget &target,
+                             const std::vector<RenderPass> &passes) {
+  const auto &bin_order{binner.get_bin_order()};
+
+  for (auto i{next_bin.fetch_add(1, std::memory_order_relaxed)};
+       i < bin_order.size();
+       i = next_bin.fetch_add(1, std::memory_order_relaxed)) {
+    const auto start{std::chrono::steady_clock::now()};
+
+    render_bin(target, bin_order[i], passes);
 
-  for (auto y{rt.box.min.y}; y < rt.box.max.y; y++) {
-    pixel_processor.iterate_x(y);
-    pixel_processor.step_y();
+    const std::chrono::duration<float, std::micro> cost{
+        std::chrono::steady_clock::now() - start};
+
+    binner.set_bin_cost(bin_order[i], cost.count());
   }
 }
 
@@ -346,39 +829,151 @@ void Rasteriser::render_scene(const Scene &scene,
                               BS::thread_pool &thread_pool) {
   futures.clear();
 
-  for (uint i{0}; i < binner.get_bins().size(); i++)
-    futures.push_back(thread_pool.submit_task([this, i] {
-      clear_bin(binner.get_bins()[i]);
-      binner.get_render_bin_group(i).clear();
-    }));
+  visible_instances.clear();
+  visible_meshlets.clear();
+  triangle_offsets.clear();
+  vertex_caches.resize(scene.model_instances.size());
+
+  uint triangle_count{0};
+
+  for (uint i{0}; i < scene.model_instances.size(); i++) {
+    const auto &model_instance{scene.model_instances[i]};
+    const auto &model{model_instance.model};
+    const auto &transform{model_instance.get_transform()};
+
+    const auto vp{projection_transform * transform};
+    const auto frustum{Frustum::from_matrix(vp)};
+
+    if (model.bounds.is_outside(frustum))
+      continue;
+
+    const auto visible_index{static_cast<uint>(visible_instances.size())};
+
+    const glm::vec3 camera_position{glm::inverse(transform) *
+                                    glm::vec4{0.0f, 0.0f, 0.0f, 1.0f}};
+
+    const auto is_mirrored{
+        glm::dot(glm::cross(glm::vec3{transform[0]}, glm::vec3{transform[1]}),
+                 glm::vec3{transform[2]}) < 0.0f};
+
+    vertex_ranges.clear();
+
+    for (uint j{0}; j < model.meshlets.size(); j++) {
+      const auto &meshlet{model.meshlets[j]};
+
+      if (meshlet.is_culled(frustum, camera_position, is_mirrored))
+        continue;
+
+      visible_meshlets.emplace_back(visible_index, j);
+      triangle_offsets.push_back(triangle_count);
+      triangle_count += meshlet.triangle_count;
+
+      vertex_ranges.emplace_back(meshlet.first_vertex, meshlet.last_vertex);
+    }
+
+    if (vertex_ranges.empty())
+      continue;
+
+    visible_instances.push_back(i);
+
+    const auto vertex_count{static_cast<uint>(model.vertices.size())};
+
+    vertex_caches[visible_index].resize(vertex_count);
+
+    std::sort(std::begin(vertex_ranges), std::end(vertex_ranges));
+
+    // transform only the vertices the visible meshlets reference, starting
+    // each range on a multiple of VERTEX_LANE_WIDTH so every lane's loads and
+    // stores stay SIMD aligned
+    uint first{0};
+    uint last{0};
+
+    for (const auto &[range_first, range_last] : vertex_ranges) {
+      const auto aligned_first{range_first - range_first % VERTEX_LANE_WIDTH};
+
+      if (aligned_first > last) {
+        transform_vertices(model, visible_index, vp, first, last, thread_pool);
+        first = aligned_first;
+      }
+
+      last = std::max(last, std::min(vertex_count, range_last));
+    }
+
+    transform_vertices(model, visible_index, vp, first, last, thread_pool);
+  }
+
+  // the visibility buffer's ids only have room for so many queues
+  const auto queue_count{
+      std::min(static_cast<uint>(thread_pool.get_thread_count()),
+               VisibilityBuffer::MAX_QUEUE_COUNT)};
+
+  binner.update_layout(queue_count);
+  binner.resize_queues(queue_count);
 
   for (auto &future : futures)
     future.get();
 
   futures.clear();
 
-  for (const auto &model_instance : scene.model_instances) {
-    const auto &model{model_instance.model};
+  // each worker bins a contiguous slice of the scene into its own queue, so
+  // consuming the queues in order reproduces submission order
+  const auto triangles_per_queue{(triangle_count + queue_count - 1) /
+                                 queue_count};
+
+  for (uint i{0}; i < queue_count; i++) {
+    const auto first_triangle{
+        std::min(triangle_count, i * triangles_per_queue)};
 
-    for (const auto &triangle : model.triangles)
-      process_triangle(model.vertices, triangle,
-                       model_instance.get_transform());
+    const auto last_triangle{
+        std::min(triangle_count, first_triangle + triangles_per_queue)};
+
+    futures.push_back(thread_pool.submit_task(
+        [this, &scene, i, first_triangle, last_triangle] {
+          process_triangles(scene, i, first_triangle, last_triangle);
+        }));
   }
 
-  for (uint i{0}; i < binner.get_bins().size(); i++)
-    futures.push_back(thread_pool.submit_task([this, i] {
-      for (auto &rt : binner.get_render_bin_group(i))
-        render_triangle(rt);
-    }));
+  for (auto &future : futures)
+    future.get();
+
+  futures.clear();
+
+  // each bin sorts its triangles, then runs its passes in order over them
+  std::vector<RenderPass> passes{PASS_COLOUR};
+
+  if (is_visibility_buffer_enabled)
+    passes = {PASS_VISIBILITY};
+  else if (is_depth_prepass_enabled)
+    passes = {PASS_DEPTH, PASS_COLOUR_EQUAL};
+
+  // one tile target per worker, reused by every bin it takes
+  if (tile_targets.size() != queue_count) {
+    tile_targets.resize(queue_count);
+
+    for (auto &target : tile_targets)
+      target.create({RenderTarget::TILE_SIZE, RenderTarget::TILE_SIZE},
+                    depth_format);
+  }
+
+  next_bin.store(0, std::memory_order_relaxed);
+
+  for (uint i{0}; i < queue_count; i++)
+    futures.push_back(thread_pool.submit_task(
+        [this, i, &passes] { render_bins(tile_targets[i], passes); }));
 
   for (auto &future : futures)
     future.get();
+
+  if (is_cost_ordering_enabled)
+    binner.order_bins_by_cost();
 }
 
 const sf::Texture &Rasteriser::get_texture() const {
-  return render_target.blit();
+  texture.update(frame_buffer.get_pixels());
+
+  return texture;
 }
 
-const glm::ivec2 &Rasteriser::get_size() const { return render_target.size; }
+const glm::ivec2 &Rasteriser::get_size() const { return size; }
 
 } // namespace Archa
@@ -0,0 +1,78 @@
+#include "rasteriser.hpp"
+
+#include "intrinsics.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+void Rasteriser::iterate_boxes_avx2(
+    const BoundingBox &box,
+    const std::vector<std::pair<uint, BoundingBox>> &boxes,
+    const std::array<int, 3> &w_row, const std::array<glm::ivec2, 3> &delta_w,
+    uint &i, uint queue_index, RenderTriangle &render_triangle) {
+
+  std::array<__m256i, 3> w_row_vec256{};
+  std::array<__m256i, 3> delta_w_vec256{};
+
+  const auto boxes_per_avx2_lane{AVX2::LANE_WIDTH / 2};
+
+  if (boxes.size() >= boxes_per_avx2_lane) {
+    for (uint i{0}; i < 3; i++) {
+      w_row_vec256[i] =
+          AVX2::set_ints(w_row[i], w_row[i], w_row[i], w_row[i], 0, 0, 0, 0);
+
+      delta_w_vec256[i] = AVX2::set_ints(
+          delta_w[i].x, delta_w[i].x, delta_w[i].x, delta_w[i].x, delta_w[i].y,
+          delta_w[i].y, delta_w[i].y, delta_w[i].y);
+    }
+  }
+
+  for (; static_cast<int>(i) < std::ssize(boxes) - (boxes_per_avx2_lane - 1);
+       i += boxes_per_avx2_lane) {
+    __m256i box_min_vec256{AVX2::set_ints(box.min.x, box.min.x, box.min.x,
+                                          box.min.x, box.min.y, box.min.y,
+                                          box.min.y, box.min.y)};
+
+    __m256i boxes_min_vec256{
+        AVX2::set_ints(boxes[i + 3].second.min.x, boxes[i + 2].second.min.x,
+                       boxes[i + 1].second.min.x, boxes[i].second.min.x,
+                       boxes[i + 3].second.min.y, boxes[i + 2].second.min.y,
+                       boxes[i + 1].second.min.y, boxes[i].second.min.y)};
+
+    __m256i box_difference_vec256{
+        AVX2::subtract_ints(boxes_min_vec256, box_min_vec256)};
+
+    ALIGN_SSE2 std::array<std::array<int, 4>, 3> new_w_row{};
+
+    for (uint j{0}; j < 3; j++) {
+      const auto &new_w_row_vec256{AVX2::add_ints(
+          w_row_vec256[j],
+          AVX2::multiply_ints(delta_w_vec256[j], box_difference_vec256))};
+
+      const auto &new_w_row_vec{
+          SSE2::add_ints(AVX2::extract_ints128<0>(new_w_row_vec256),
+                         AVX2::extract_ints128<1>(new_w_row_vec256))};
+
+      SSE2::store_ints(new_w_row[j].data(), new_w_row_vec);
+    }
+
+    for (uint j{0}; j < boxes_per_avx2_lane; j++) {
+      const auto box_index{i + j};
+
+      const std::array<int, 3> w_row_new_j{new_w_row[0][j], new_w_row[1][j],
+                                           new_w_row[2][j]};
+
+      render_triangle.box = boxes[box_index].second;
+      render_triangle.w_row = w_row_new_j;
+
+      bin_triangle(queue_index, boxes[box_index].first, render_triangle);
+    }
+  }
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
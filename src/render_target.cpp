@@ -2,18 +2,48 @@
 
 namespace Archa {
 
-void RenderTarget::create(const glm::ivec2 &size) {
+void RenderTarget::create(const glm::ivec2 &size, DepthFormat depth_format) {
   this->size = size;
 
-  z_buffer.create(size);
+  z_buffer.create(size, depth_format);
+  visibility_buffer.create(size);
   frame_buffer.create(size);
-  texture.create(static_cast<uint>(size.x), static_cast<uint>(size.y));
 }
 
-const sf::Texture &RenderTarget::blit() const {
-  texture.update(frame_buffer.get_pixels());
+void RenderTarget::fill_block(const glm::ivec2 &pos) {
+  const auto block_min{pos / ZBuffer::BLOCK_SIZE * ZBuffer::BLOCK_SIZE};
 
-  return texture;
+  frame_buffer.fill(block_min,
+                    glm::min(size, block_min + ZBuffer::BLOCK_SIZE),
+                    clear_colour);
+}
+
+void RenderTarget::clear(const Colour &colour) {
+  z_buffer.clear_blocks({0, 0}, size);
+
+  clear_colour = colour;
+}
+
+void RenderTarget::resolve_clears(const glm::ivec2 &min,
+                                  const glm::ivec2 &max) {
+  const auto block_min{min / ZBuffer::BLOCK_SIZE * ZBuffer::BLOCK_SIZE};
+
+  for (auto y{block_min.y}; y < max.y; y += ZBuffer::BLOCK_SIZE) {
+    for (auto x{block_min.x}; x < max.x; x += ZBuffer::BLOCK_SIZE) {
+      if (!z_buffer.is_clear_pending({x, y}))
+        continue;
+
+      z_buffer.resolve_clear({x, y});
+      fill_block({x, y});
+    }
+  }
+}
+
+void RenderTarget::resolve_colour_clears() {
+  for (auto y{0}; y < size.y; y += ZBuffer::BLOCK_SIZE)
+    for (auto x{0}; x < size.x; x += ZBuffer::BLOCK_SIZE)
+      if (z_buffer.is_clear_pending({x, y}))
+        fill_block({x, y});
 }
 
 } // namespace Archa
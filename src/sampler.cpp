@@ -0,0 +1,57 @@
+#include "sampler.hpp"
+
+#include <array>
+#include <cmath>
+
+#include "constants.hpp"
+
+namespace Archa {
+
+// texel coordinates of the two taps either side of t along one axis, wrapped
+// into [0, size), with the weight of the second tap
+static std::tuple<int, int, float> get_tap_coords(float t, int size) {
+  const auto coord{(t - std::floor(t)) * static_cast<float>(size) - 0.5f};
+  const auto floor{std::floor(coord)};
+
+  auto coord0{static_cast<int>(floor)};
+  auto coord1{coord0 + 1};
+
+  if (coord0 < 0)
+    coord0 += size;
+
+  if (coord1 >= size)
+    coord1 -= size;
+
+  return {coord0, coord1, coord - floor};
+}
+
+Colour sample_bilinear(const MipLevel &level, const glm::vec2 &uv) {
+  const auto [x0, x1, weight_x]{get_tap_coords(uv.x, level.size.x)};
+  const auto [y0, y1, weight_y]{get_tap_coords(uv.y, level.size.y)};
+
+  const auto get_texel{[&](int x, int y) {
+    return level.get_texel(x, y);
+  }};
+
+  const std::array<uint32, 4> texels{get_texel(x0, y0), get_texel(x1, y0),
+                                     get_texel(x0, y1), get_texel(x1, y1)};
+
+  std::array<uint8, RGBA_CHANNEL_COUNT> channels{};
+
+  for (uint c{0}; c < channels.size(); c++) {
+    std::array<float, 4> taps{};
+
+    for (uint i{0}; i < taps.size(); i++)
+      taps[i] = static_cast<float>((texels[i] >> (c * 8)) & 0xFF);
+
+    const auto top{taps[0] + (taps[1] - taps[0]) * weight_x};
+    const auto bottom{taps[2] + (taps[3] - taps[2]) * weight_x};
+
+    channels[c] = static_cast<uint8>(
+        std::lround(top + (bottom - top) * weight_y));
+  }
+
+  return {channels[0], channels[1], channels[2], channels[3]};
+}
+
+} // namespace Archa
@@ -0,0 +1,69 @@
+#include "shading.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "sampler.hpp"
+
+namespace Archa {
+
+glm::vec2 interpolate_uv(const RenderTriangle &rt, const glm::vec2 &offset) {
+  return glm::vec2{rt.uv_over_w_planes[0].get(offset),
+                   rt.uv_over_w_planes[1].get(offset)} /
+         rt.inv_w_plane.get(offset);
+}
+
+uint select_mip_level(const RenderTriangle &rt, const glm::vec2 &offset) {
+  const auto &texture{*rt.triangle.diffuse_texture};
+
+  if (texture.get_level_count() == 1)
+    return 0;
+
+  const auto inv_w{rt.inv_w_plane.get(offset)};
+  const auto uv{interpolate_uv(rt, offset)};
+
+  // quotient rule on uv = (uv / w) / (1 / w)
+  const auto get_derivative{[&](float duv_over_w_x, float duv_over_w_y,
+                                float dinv_w) {
+    return glm::vec2{duv_over_w_x - uv.x * dinv_w,
+                     duv_over_w_y - uv.y * dinv_w} /
+           inv_w * glm::vec2{texture.get_size()};
+  }};
+
+  const auto &planes{rt.uv_over_w_planes};
+
+  const auto duv_dx{
+      get_derivative(planes[0].a, planes[1].a, rt.inv_w_plane.a)};
+
+  const auto duv_dy{
+      get_derivative(planes[0].b, planes[1].b, rt.inv_w_plane.b)};
+
+  const auto rho_squared{
+      std::max(glm::dot(duv_dx, duv_dx), glm::dot(duv_dy, duv_dy))};
+
+  // also rejects NaN from degenerate derivatives
+  if (!(rho_squared > 1.0f))
+    return 0;
+
+  const auto level{static_cast<uint>(0.5f * std::log2(rho_squared) + 0.5f)};
+
+  return std::min(level, texture.get_level_count() - 1);
+}
+
+Colour shade_pixel(const RenderTriangle &rt, const glm::vec2 &offset) {
+  if (const auto &texture{rt.triangle.diffuse_texture}) {
+    const auto &level{texture->get_level(select_mip_level(rt, offset))};
+
+    return sample_bilinear(level, interpolate_uv(rt, offset));
+  }
+
+  std::array<uint8, RGBA_CHANNEL_COUNT> channels{};
+
+  for (uint c{0}; c < channels.size(); c++)
+    channels[c] = static_cast<uint8>(
+        std::clamp(rt.colour_planes[c].get(offset) + 0.5f, 0.0f, 255.0f));
+
+  return {channels[0], channels[1], channels[2], channels[3]};
+}
+
+} // namespace Archa
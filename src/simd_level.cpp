@@ -0,0 +1,85 @@
+#include "simd_level.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+#include "logger.hpp"
+
+namespace Archa {
+
+static SimdLevel get_supported_simd_level() {
+  return std::min(get_compiled_simd_level(), get_cpu_simd_level());
+}
+
+// read by every kernel, written only when the level is overridden
+static std::atomic<SimdLevel> simd_level{get_supported_simd_level()};
+
+SimdLevel get_compiled_simd_level() {
+#ifdef USING_SIMD_AVX2
+  return SimdLevel::AVX2;
+#elif defined USING_SIMD_SSE2
+  return SimdLevel::SSE2;
+#else
+  return SimdLevel::NONE;
+#endif
+}
+
+SimdLevel get_cpu_simd_level() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  // may run before the runtime has initialised its cpu model
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    return SimdLevel::AVX2;
+
+  // the SSE2 kernels also lean on a few SSE4.1 instructions
+  if (__builtin_cpu_supports("sse4.1"))
+    return SimdLevel::SSE2;
+#endif
+
+  return SimdLevel::NONE;
+}
+
+SimdLevel get_simd_level() {
+  return simd_level.load(std::memory_order_relaxed);
+}
+
+void set_simd_level(SimdLevel level) {
+  const auto supported_level{get_supported_simd_level()};
+
+  if (level > supported_level) {
+    Logger().warn() << to_string(level) << " is not supported, using "
+                    << to_string(supported_level) << '\n';
+
+    level = supported_level;
+  }
+
+  simd_level.store(level, std::memory_order_relaxed);
+}
+
+const char *to_string(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::NONE:
+    return "scalar";
+  case SimdLevel::SSE2:
+    return "SSE2";
+  case SimdLevel::AVX2:
+    return "AVX2";
+  }
+
+  return "unknown";
+}
+
+std::optional<SimdLevel> parse_simd_level(std::string_view name) {
+  for (const auto level : {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2})
+    if (std::ranges::equal(name, std::string_view{to_string(level)},
+                           [](char a, char b) {
+                             return std::tolower(a) == std::tolower(b);
+                           }))
+      return level;
+
+  return std::nullopt;
+}
+
+} // namespace Archa
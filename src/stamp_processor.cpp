@@ -0,0 +1,76 @@
+#include "stamp_processor.hpp"
+
+#include "shading.hpp"
+#include "simd_level.hpp"
+
+namespace Archa {
+
+StampProcessor::StampProcessor(RenderTarget &render_target)
+    : render_target{render_target} {}
+
+bool StampProcessor::fits(const BoundingBox &box) {
+  const auto size{box.max - box.min};
+
+  return size.x <= SIZE && size.y <= SIZE;
+}
+
+void StampProcessor::process_pixel(const TileTriangle &tile, RenderPass pass,
+                                   const glm::ivec2 &pos) {
+  const auto &rt{*tile.triangle};
+
+  auto &z_buffer{render_target.z_buffer};
+
+  const glm::vec2 offset{pos - tile.origin};
+  const auto z{z_buffer.quantise(rt.z_plane.get(offset))};
+
+  if (!passes_depth_test(pass, z, z_buffer.get(pos)))
+    return;
+
+  if (pass != PASS_COLOUR_EQUAL)
+    z_buffer.set(pos, z);
+
+  if (pass == PASS_VISIBILITY)
+    render_target.visibility_buffer.set(pos, rt.id);
+  else if (pass != PASS_DEPTH)
+    render_target.frame_buffer.set_pixel(pos, shade_pixel(rt, offset));
+}
+
+void StampProcessor::render(const TileTriangle &tile, RenderPass pass) {
+  const auto &rt{*tile.triangle};
+
+  alignas(SIMD_ALIGN_WIDTH) StampInts coverage{};
+
+  uint i{0};
+
+  [[maybe_unused]] const auto simd_level{get_simd_level()};
+
+#ifdef USING_SIMD_AVX2
+  if (simd_level >= SimdLevel::AVX2)
+    i = compute_coverage_avx2(tile, i, coverage);
+#endif
+
+#ifdef USING_SIMD_SSE2
+  if (simd_level >= SimdLevel::SSE2)
+    i = compute_coverage_sse2(tile, i, coverage);
+#endif
+
+  const auto box_size{tile.box.max - tile.box.min};
+
+  for (; i < PIXEL_COUNT; i++) {
+    coverage[i] = (box_size.x - 1 - STAMP_X[i]) | (box_size.y - 1 - STAMP_Y[i]);
+
+    for (uint j{0}; j < rt.delta_w.size(); j++)
+      coverage[i] |= tile.w_row[j] + rt.delta_w[j].x * STAMP_X[i] +
+                     rt.delta_w[j].y * STAMP_Y[i];
+  }
+
+  for (uint i{0}; i < PIXEL_COUNT; i++) {
+    if (coverage[i] < 0)
+      continue;
+
+    process_pixel(tile, pass,
+                  tile.box.min + glm::ivec2{STAMP_X[i], STAMP_Y[i]});
+  }
+}
+
+} // namespace Archa
@@ -0,0 +1,19 @@
+#include "stamp_processor.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+uint StampProcessor::compute_coverage_avx2(const TileTriangle &tile, uint i,
+                                           StampInts &coverage) {
+  for (; i < PIXEL_COUNT; i += AVX2::LANE_WIDTH)
+    compute_coverage<AVX2>(tile, i, coverage);
+
+  return i;
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
@@ -0,0 +1,19 @@
+#include "stamp_processor.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+
+uint StampProcessor::compute_coverage_sse2(const TileTriangle &tile, uint i,
+                                           StampInts &coverage) {
+  for (; i < PIXEL_COUNT; i += SSE2::LANE_WIDTH)
+    compute_coverage<SSE2>(tile, i, coverage);
+
+  return i;
+}
+
+END_SSE2_TARGET
+#endif
+
+} // namespace Archa
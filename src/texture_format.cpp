@@ -0,0 +1,57 @@
+#include "texture_format.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+namespace Archa {
+
+static std::atomic<TextureFormat> texture_format{TextureFormat::RGBA8};
+
+TextureFormat get_texture_format() {
+  return texture_format.load(std::memory_order_relaxed);
+}
+
+void set_texture_format(TextureFormat format) {
+  texture_format.store(format, std::memory_order_relaxed);
+}
+
+uint get_block_size(TextureFormat format) {
+  switch (format) {
+  case TextureFormat::RGBA8:
+    return 0;
+  case TextureFormat::BC1:
+    return 8;
+  case TextureFormat::BC3:
+    return 16;
+  }
+
+  return 0;
+}
+
+const char *to_string(TextureFormat format) {
+  switch (format) {
+  case TextureFormat::RGBA8:
+    return "RGBA8";
+  case TextureFormat::BC1:
+    return "BC1";
+  case TextureFormat::BC3:
+    return "BC3";
+  }
+
+  return "unknown";
+}
+
+std::optional<TextureFormat> parse_texture_format(std::string_view name) {
+  for (const auto format :
+       {TextureFormat::RGBA8, TextureFormat::BC1, TextureFormat::BC3})
+    if (std::ranges::equal(name, std::string_view{to_string(format)},
+                           [](char a, char b) {
+                             return std::tolower(a) == std::tolower(b);
+                           }))
+      return format;
+
+  return std::nullopt;
+}
+
+} // namespace Archa
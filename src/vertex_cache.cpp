@@ -0,0 +1,80 @@
+#include "vertex_cache.hpp"
+
+#include "simd_level.hpp"
+
+namespace Archa {
+
+// widest SIMD lane, so every batch of the last lane can store aligned
+static constexpr uint LANE_PADDING{8};
+
+void VertexCache::transform_single(const std::vector<Vertex> &vertices,
+                                   const glm::mat4 &vp,
+                                   const glm::mat4 &screen_space_transform,
+                                   uint i) {
+
+  const auto clip{vp * glm::vec4{vertices[i], 1.0f}};
+  const auto screen{screen_space_transform * clip};
+  // halves round to even, as in the lane kernels' conversion, so a vertex
+  // lands on the same sub-pixel whichever path transforms it
+  const glm::ivec2 screen_pos{glm::roundEven(glm::vec2{screen} / screen.w)};
+
+  clip_x[i] = clip.x;
+  clip_y[i] = clip.y;
+  clip_z[i] = clip.z;
+  clip_w[i] = clip.w;
+
+  screen_x[i] = screen_pos.x;
+  screen_y[i] = screen_pos.y;
+}
+
+void VertexCache::resize(uint count) {
+  const auto padded_count{(count + LANE_PADDING - 1) / LANE_PADDING *
+                          LANE_PADDING};
+
+  clip_x.resize(padded_count);
+  clip_y.resize(padded_count);
+  clip_z.resize(padded_count);
+  clip_w.resize(padded_count);
+
+  screen_x.resize(padded_count);
+  screen_y.resize(padded_count);
+
+  outcodes.resize(count);
+}
+
+void VertexCache::transform(const std::vector<Vertex> &vertices,
+                            const glm::mat4 &vp,
+                            const glm::mat4 &screen_space_transform,
+                            const Clipper &clipper, uint first, uint last) {
+  auto i{first};
+
+  [[maybe_unused]] const auto simd_level{get_simd_level()};
+
+#ifdef USING_SIMD_AVX2
+  if (simd_level >= SimdLevel::AVX2)
+    i = transform_lanes_avx2(vertices, vp, screen_space_transform, i, last);
+#endif
+
+#ifdef USING_SIMD_SSE2
+  if (simd_level >= SimdLevel::SSE2)
+    i = transform_lanes_sse2(vertices, vp, screen_space_transform, i, last);
+#endif
+
+  for (; i < last; i++)
+    transform_single(vertices, vp, screen_space_transform, i);
+
+  for (i = first; i < last; i++)
+    outcodes[i] = clipper.compute_outcode(get_clip(i));
+}
+
+glm::vec4 VertexCache::get_clip(uint i) const {
+  return {clip_x[i], clip_y[i], clip_z[i], clip_w[i]};
+}
+
+glm::ivec2 VertexCache::get_screen(uint i) const {
+  return {screen_x[i], screen_y[i]};
+}
+
+uint8 VertexCache::get_outcode(uint i) const { return outcodes[i]; }
+
+} // namespace Archa
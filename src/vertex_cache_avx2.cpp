@@ -0,0 +1,26 @@
+#include "vertex_cache.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+uint VertexCache::transform_lanes_avx2(const std::vector<Vertex> &vertices,
+                                      const glm::mat4 &vp,
+                                      const glm::mat4 &screen_space_transform,
+                                      uint i, uint last) {
+  const auto vp_vec256s{set_matrix<AVX2>(vp)};
+  const auto screen_vec256s{set_matrix<AVX2>(screen_space_transform)};
+
+  for (; i + AVX2::LANE_WIDTH <= last; i += AVX2::LANE_WIDTH)
+    transform_lanes<AVX2>(vertices, vp_vec256s, screen_vec256s, i,
+                          clip_x.data(), clip_y.data(), clip_z.data(),
+                          clip_w.data(), screen_x.data(), screen_y.data());
+
+  return i;
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
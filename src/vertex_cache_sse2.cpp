@@ -0,0 +1,26 @@
+#include "vertex_cache.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+
+uint VertexCache::transform_lanes_sse2(const std::vector<Vertex> &vertices,
+                                      const glm::mat4 &vp,
+                                      const glm::mat4 &screen_space_transform,
+                                      uint i, uint last) {
+  const auto vp_vecs{set_matrix<SSE2>(vp)};
+  const auto screen_vecs{set_matrix<SSE2>(screen_space_transform)};
+
+  for (; i + SSE2::LANE_WIDTH <= last; i += SSE2::LANE_WIDTH)
+    transform_lanes<SSE2>(vertices, vp_vecs, screen_vecs, i, clip_x.data(),
+                          clip_y.data(), clip_z.data(), clip_w.data(),
+                          screen_x.data(), screen_y.data());
+
+  return i;
+}
+
+END_SSE2_TARGET
+#endif
+
+} // namespace Archa
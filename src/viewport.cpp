@@ -25,7 +25,7 @@ void Viewport::create(glm::ivec2 size, const uint threads) {
                     << " px) not aligned to SIMD width (" << SIMD_ALIGN_WIDTH
                     << " px)" << '\n';
 
-  rasteriser.create(size, static_cast<int>(threads));
+  rasteriser.create(size);
 }
 
 void Viewport::set_camera(const Camera &camera) {
@@ -36,6 +36,26 @@ void Viewport::set_camera(const Camera &camera) {
 
 void Viewport::set_scene(const Scene &scene) { this->scene = &scene; }
 
+void Viewport::set_visibility_buffer_enabled(bool is_enabled) {
+  rasteriser.set_visibility_buffer_enabled(is_enabled);
+}
+
+void Viewport::set_depth_prepass_enabled(bool is_enabled) {
+  rasteriser.set_depth_prepass_enabled(is_enabled);
+}
+
+void Viewport::set_cost_ordering_enabled(bool is_enabled) {
+  rasteriser.set_cost_ordering_enabled(is_enabled);
+}
+
+void Viewport::set_depth_format(DepthFormat format) {
+  rasteriser.set_depth_format(format);
+}
+
+void Viewport::set_bin_layout(BinLayout layout) {
+  rasteriser.set_bin_layout(layout);
+}
+
 void Viewport::render() { rasteriser.render_scene(*scene, *thread_pool); }
 
 const sf::Texture &Viewport::get_texture() const {
@@ -0,0 +1,40 @@
+#include "visibility_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Archa {
+
+uint32 VisibilityBuffer::pack_id(uint queue_index, uint triangle_index) {
+  assert(queue_index < MAX_QUEUE_COUNT && triangle_index <= MAX_TRIANGLE_INDEX);
+
+  return queue_index << TRIANGLE_BITS | triangle_index;
+}
+
+std::pair<uint, uint> VisibilityBuffer::unpack_id(uint32 id) {
+  return {id >> TRIANGLE_BITS, id & ((1u << TRIANGLE_BITS) - 1)};
+}
+
+void VisibilityBuffer::create(const glm::ivec2 &size) {
+  this->size = size;
+
+  ids.assign(static_cast<uint>(size.x * size.y), NO_ID);
+}
+
+void VisibilityBuffer::clear(const glm::ivec2 &min, const glm::ivec2 &max) {
+  for (auto y{min.y}; y < max.y; y++) {
+    const auto row{std::begin(ids) + y * size.x};
+
+    std::fill(row + min.x, row + max.x, NO_ID);
+  }
+}
+
+void VisibilityBuffer::set(const glm::ivec2 &pos, uint32 id) {
+  ids[static_cast<uint>(pos.y * size.x + pos.x)] = id;
+}
+
+uint32 VisibilityBuffer::get(const glm::ivec2 &pos) const {
+  return ids[static_cast<uint>(pos.y * size.x + pos.x)];
+}
+
+} // namespace Archa
@@ -1,65 +1,312 @@
 #include "z_buffer.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
 #include "intrinsics.hpp"
 #include "logger.hpp"
+#include "simd_level.hpp"
 #include "types.hpp"
 
 namespace Archa {
 
-void ZBuffer::create(const glm::ivec2 &size) {
+const char *to_string(DepthFormat format) {
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    return "FLOAT32";
+  case DepthFormat::UNORM16:
+    return "UNORM16";
+  case DepthFormat::UNORM24:
+    return "UNORM24";
+  case DepthFormat::FLOAT32_REVERSED:
+    return "FLOAT32_REVERSED";
+  }
+
+  return "unknown";
+}
+
+std::optional<DepthFormat> parse_depth_format(std::string_view name) {
+  for (const auto format :
+       {DepthFormat::FLOAT32, DepthFormat::UNORM16, DepthFormat::UNORM24,
+        DepthFormat::FLOAT32_REVERSED})
+    if (std::ranges::equal(name, std::string_view{to_string(format)},
+                           [](char a, char b) {
+                             return std::tolower(a) == std::tolower(b);
+                           }))
+      return format;
+
+  return std::nullopt;
+}
+
+void ZBuffer::create(const glm::ivec2 &size, DepthFormat format) {
   this->size = size;
+  this->format = format;
+
+  const auto pixel_count{static_cast<uint>(size.x * size.y)};
+
+  float_data = {};
+  uint16_data = {};
+  uint32_data = {};
 
-  data.resize(static_cast<uint>(size.x * size.y));
-  // clear();
+  // fixed-point depths scale by 2^bits rather than 2^bits - 1, so that they
+  // decode exactly and a decoded depth encodes back to the same value
+  switch (format) {
+  case DepthFormat::FLOAT32:
+  case DepthFormat::FLOAT32_REVERSED:
+    float_data.resize(pixel_count);
+    break;
+  case DepthFormat::UNORM16:
+    uint16_data.resize(pixel_count);
+    fixed_point_scale = static_cast<float>(1 << 16);
+    break;
+  case DepthFormat::UNORM24:
+    uint32_data.resize(pixel_count);
+    fixed_point_scale = static_cast<float>(1 << 24);
+    break;
+  }
+
+  block_count = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  const auto block_total{static_cast<uint>(block_count.x * block_count.y)};
+
+  block_max.assign(block_total, get_clear_depth());
+  block_is_dirty.assign(block_total, false);
+  block_is_clear_pending.assign(block_total, false);
 }
 
-void ZBuffer::clear_single(int i) {
-  data[static_cast<uint>(i)] = std::numeric_limits<float>::max();
+DepthFormat ZBuffer::get_format() const { return format; }
+
+uint ZBuffer::get_index(const glm::ivec2 &pos) const {
+  return static_cast<uint>(pos.y * size.x + pos.x);
+}
+
+uint ZBuffer::get_block_index(const glm::ivec2 &pos) const {
+  return static_cast<uint>(pos.y / BLOCK_SIZE * block_count.x +
+                           pos.x / BLOCK_SIZE);
+}
+
+bool ZBuffer::is_fixed_point() const {
+  return format == DepthFormat::UNORM16 || format == DepthFormat::UNORM24;
 }
 
+uint32 ZBuffer::encode_fixed_point(float z) const {
+  const auto value{
+      std::clamp(z * fixed_point_scale, 0.0f, fixed_point_scale - 1.0f)};
+
+  return static_cast<uint32>(std::nearbyint(value));
+}
+
+float ZBuffer::decode_fixed_point(uint32 value) const {
+  return static_cast<float>(value) / fixed_point_scale;
+}
+
+float ZBuffer::get_clear_depth() const {
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    return std::numeric_limits<float>::max();
+  case DepthFormat::FLOAT32_REVERSED:
+    return 0.0f;
+  case DepthFormat::UNORM16:
+  case DepthFormat::UNORM24:
+    return decode_fixed_point(
+        static_cast<uint32>(fixed_point_scale - 1.0f));
+  }
+
+  return std::numeric_limits<float>::max();
+}
+
+float ZBuffer::quantise(float z) const {
+  return is_fixed_point() ? decode_fixed_point(encode_fixed_point(z)) : z;
+}
+
+float ZBuffer::get_block_max(uint block_index) {
+  // lanes running past a span may mark a pending block dirty without
+  // changing what it logically holds
+  if (!block_is_dirty[block_index] || block_is_clear_pending[block_index])
+    return block_max[block_index];
+
+  const auto block_index_int{static_cast<int>(block_index)};
+
+  const glm::ivec2 block_min{block_index_int % block_count.x * BLOCK_SIZE,
+                             block_index_int / block_count.x * BLOCK_SIZE};
+
+  const auto block_max_pos{glm::min(size, block_min + BLOCK_SIZE)};
+
+  auto result{std::numeric_limits<float>::lowest()};
+
+  auto y{block_min.y};
+
 #ifdef USING_SIMD_AVX2
-void ZBuffer::clear_lane_avx2(int i) {
-  static const auto z_values_vec256{
-      AVX2::set_float(std::numeric_limits<float>::max())};
+  // each row of a whole block is one lane
+  if (get_simd_level() >= SimdLevel::AVX2 &&
+      block_max_pos.x - block_min.x == AVX2::LANE_WIDTH) {
+    result = get_rows_max_avx2(block_min, block_max_pos.y);
+
+    y = block_max_pos.y;
+  }
+#endif
 
-  AVX2::store_floats(&data[static_cast<uint>(i)], z_values_vec256);
+  for (; y < block_max_pos.y; y++)
+    for (auto x{block_min.x}; x < block_max_pos.x; x++)
+      result = std::max(result, get({x, y}));
+
+  block_max[block_index] = result;
+  block_is_dirty[block_index] = false;
+
+  return result;
 }
+
+void ZBuffer::clear_blocks(const glm::ivec2 &min, const glm::ivec2 &max) {
+  const auto clear_depth{get_clear_depth()};
+
+  for (auto y{min.y}; y < max.y; y += BLOCK_SIZE) {
+    for (auto x{min.x}; x < max.x; x += BLOCK_SIZE) {
+      const auto i{get_block_index({x, y})};
+
+      block_max[i] = clear_depth;
+      block_is_dirty[i] = false;
+      block_is_clear_pending[i] = true;
+    }
+  }
+}
+
+bool ZBuffer::is_clear_pending(const glm::ivec2 &pos) const {
+  return block_is_clear_pending[get_block_index(pos)];
+}
+
+void ZBuffer::resolve_clear(const glm::ivec2 &pos) {
+  const auto block_index{get_block_index(pos)};
+
+  const auto block_min{pos / BLOCK_SIZE * BLOCK_SIZE};
+  const auto block_max_pos{glm::min(size, block_min + BLOCK_SIZE)};
+
+  [[maybe_unused]] const auto simd_level{get_simd_level()};
+
+  for (auto y{block_min.y}; y < block_max_pos.y; y++) {
+    auto x{block_min.x};
+    auto i{static_cast<int>(get_index({x, y}))};
+
+#ifdef USING_SIMD_AVX2
+    if (simd_level >= SimdLevel::AVX2) {
+      const auto count{clear_lanes_avx2(i, block_max_pos.x - x)};
+
+      x += count;
+      i += count;
+    }
 #endif
 
 #ifdef USING_SIMD_SSE2
-void ZBuffer::clear_lane_sse2(int i) {
-  static const auto z_values_vec{
-      SSE2::set_float(std::numeric_limits<float>::max())};
+    if (simd_level >= SimdLevel::SSE2) {
+      const auto count{clear_lanes_sse2(i, block_max_pos.x - x)};
 
-  SSE2::store_floats(&data[static_cast<uint>(i)], z_values_vec);
-}
+      x += count;
+      i += count;
+    }
 #endif
 
-// void ZBuffer::clear() {
-//   auto i{0};
+    for (; x < block_max_pos.x; x++, i++)
+      clear_single(i);
+  }
+
+  block_max[block_index] = get_clear_depth();
+  block_is_dirty[block_index] = false;
+  block_is_clear_pending[block_index] = false;
+}
+
+bool ZBuffer::is_occluded(const BoundingBox &box, float z) {
+  for (auto y{box.min.y - box.min.y % BLOCK_SIZE}; y < box.max.y;
+       y += BLOCK_SIZE) {
+
+    const auto [min_x, max_x]{find_visible_span(y, box.min.x, box.max.x, z)};
+
+    if (min_x < max_x)
+      return false;
+  }
+
+  return true;
+}
+
+std::pair<int, int> ZBuffer::find_visible_span(int y, int min_x, int max_x,
+                                               float z) {
+  const auto row_index{y / BLOCK_SIZE * block_count.x};
+
+  auto first{min_x / BLOCK_SIZE};
+  auto last{(max_x + BLOCK_SIZE - 1) / BLOCK_SIZE};
+
+  while (first < last &&
+         z >= get_block_max(static_cast<uint>(row_index + first)))
+    first++;
+
+  while (last > first &&
+         z >= get_block_max(static_cast<uint>(row_index + last - 1)))
+    last--;
 
-// #ifdef USING_SIMD_AVX2
-//   for (; i < std::ssize(data) - (AVX2::LANE_WIDTH - 1); i +=
-//   AVX2::LANE_WIDTH)
-//     clear_lane_avx2(i);
-// #endif
+  return {std::max(min_x, first * BLOCK_SIZE),
+          std::min(max_x, last * BLOCK_SIZE)};
+}
 
-// #ifdef USING_SIMD_SSE2
-//   for (; i < std::ssize(data) - (SSE2::LANE_WIDTH - 1); i +=
-//   SSE2::LANE_WIDTH)
-//     clear_lane_sse2(i);
-// #endif
+void ZBuffer::clear_single(int i) {
+  const auto index{static_cast<uint>(i)};
 
-//   std::fill(std::begin(data) + i, std::end(data),
-//             std::numeric_limits<float>::max());
-// }
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    float_data[index] = std::numeric_limits<float>::max();
+    break;
+  case DepthFormat::FLOAT32_REVERSED:
+    float_data[index] = 0.0f;
+    break;
+  case DepthFormat::UNORM16:
+    uint16_data[index] = std::numeric_limits<uint16>::max();
+    break;
+  case DepthFormat::UNORM24:
+    uint32_data[index] = static_cast<uint32>(fixed_point_scale - 1.0f);
+    break;
+  }
+}
+
+void ZBuffer::mark_blocks_dirty(const glm::ivec2 &pos, int width) {
+  block_is_dirty[get_block_index(pos)] = true;
+  block_is_dirty[get_block_index({pos.x + width - 1, pos.y})] = true;
+}
 
 void ZBuffer::set(const glm::ivec2 &pos, float value) {
-  data[static_cast<uint>(pos.y * size.x + pos.x)] = value;
+  const auto i{get_index(pos)};
+
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    float_data[i] = value;
+    break;
+  case DepthFormat::FLOAT32_REVERSED:
+    float_data[i] = -value;
+    break;
+  case DepthFormat::UNORM16:
+    uint16_data[i] = static_cast<uint16>(encode_fixed_point(value));
+    break;
+  case DepthFormat::UNORM24:
+    uint32_data[i] = encode_fixed_point(value);
+    break;
+  }
+
+  block_is_dirty[get_block_index(pos)] = true;
 }
 
 float ZBuffer::get(const glm::ivec2 &pos) const {
-  return data[static_cast<uint>(pos.y * size.x + pos.x)];
+  const auto i{get_index(pos)};
+
+  switch (format) {
+  case DepthFormat::FLOAT32:
+    return float_data[i];
+  case DepthFormat::FLOAT32_REVERSED:
+    return -float_data[i];
+  case DepthFormat::UNORM16:
+    return decode_fixed_point(uint16_data[i]);
+  case DepthFormat::UNORM24:
+    return decode_fixed_point(uint32_data[i]);
+  }
+
+  return get_clear_depth();
 }
 
 } // namespace Archa
@@ -0,0 +1,54 @@
+#include "z_buffer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Archa {
+
+#ifdef USING_SIMD_AVX2
+BEGIN_AVX2_TARGET
+
+__m256 ZBuffer::quantise_lane_avx2(const __m256 &z_vec) const {
+  return quantise_lane<AVX2>(z_vec);
+}
+
+int ZBuffer::clear_lanes_avx2(int i, int count) {
+  auto cleared{0};
+
+  for (; cleared < count - (AVX2::LANE_WIDTH - 1);
+       cleared += AVX2::LANE_WIDTH)
+    clear_lane<AVX2>(i + cleared);
+
+  return cleared;
+}
+
+float ZBuffer::get_rows_max_avx2(const glm::ivec2 &pos, int max_y) const {
+  auto max_vec{AVX2::set_float(std::numeric_limits<float>::lowest())};
+
+  for (auto y{pos.y}; y < max_y; y++)
+    max_vec = AVX2::max_floats(max_vec, get_lane<AVX2>({pos.x, y}));
+
+  alignas(SIMD_ALIGN_WIDTH) AVX2::Array<float> max_values{};
+  AVX2::store_floats(max_values.data(), max_vec);
+
+  return *std::max_element(std::begin(max_values), std::end(max_values));
+}
+
+int ZBuffer::test_and_set_lane_avx2(const glm::ivec2 &pos, const __m256 &z_vec,
+                                    const __m256 &mask_vec) {
+  return test_and_set_lane<AVX2>(pos, z_vec, mask_vec);
+}
+
+__m256 ZBuffer::get_lane_avx2(const glm::ivec2 &pos) const {
+  return get_lane<AVX2>(pos);
+}
+
+void ZBuffer::set_lane_avx2(const glm::ivec2 &pos, const __m256 &z_vec,
+                            const __m256 &mask_vec) {
+  set_lane<AVX2>(pos, z_vec, mask_vec);
+}
+
+END_AVX2_TARGET
+#endif
+
+} // namespace Archa
@@ -0,0 +1,39 @@
+#include "z_buffer.hpp"
+
+namespace Archa {
+
+#ifdef USING_SIMD_SSE2
+BEGIN_SSE2_TARGET
+
+__m128 ZBuffer::quantise_lane_sse2(const __m128 &z_vec) const {
+  return quantise_lane<SSE2>(z_vec);
+}
+
+int ZBuffer::clear_lanes_sse2(int i, int count) {
+  auto cleared{0};
+
+  for (; cleared < count - (SSE2::LANE_WIDTH - 1);
+       cleared += SSE2::LANE_WIDTH)
+    clear_lane<SSE2>(i + cleared);
+
+  return cleared;
+}
+
+int ZBuffer::test_and_set_lane_sse2(const glm::ivec2 &pos, const __m128 &z_vec,
+                                    const __m128 &mask_vec) {
+  return test_and_set_lane<SSE2>(pos, z_vec, mask_vec);
+}
+
+__m128 ZBuffer::get_lane_sse2(const glm::ivec2 &pos) const {
+  return get_lane<SSE2>(pos);
+}
+
+void ZBuffer::set_lane_sse2(const glm::ivec2 &pos, const __m128 &z_vec,
+                            const __m128 &mask_vec) {
+  set_lane<SSE2>(pos, z_vec, mask_vec);
+}
+
+END_SSE2_TARGET
+#endif
+
+} // namespace Archa